@@ -17,8 +17,9 @@ ExplosionInfo
 		falloff,
 		damage,
 		impulse;
-	SpriteInfo *sprite_info;
-	Renderable  renderable;
+	SpriteInfo     *sprite_info;
+	Renderable      renderable;
+	EntityArchetype archetype;
 }
 ExplosionInfo;
 
@@ -46,6 +47,14 @@ Renderable
 			.transparent = true,
 		};
 
+EntityArchetype
+Explosion_Archetype = {
+		.name          = "explosion",
+		.renderables   = {&explosion_Renderable},
+		.lod_distances = {512.0f},
+		.lod_count     = 1,
+	};
+
 EntityVTable 
 Explosion_Callbacks = {
 		.Setup       = NULL,
@@ -60,9 +69,7 @@ Explosion_Callbacks = {
 
 Entity
 Explosion_Template = {
-		.renderables       = {&explosion_Renderable},
-		.lod_distances     = {512.0f},
-		.lod_count         = 1,
+		.archetype         = &Explosion_Archetype,
 		.visibility_radius = 0.25f,
 		.bounds            = {0.1f, 0.1f, 0.1f},
 		.bounds_offset     = {0.0f, 0.0f, 0.0f},
@@ -101,7 +108,7 @@ explosionRender(Entity *self, float delta)
 	(void)delta;
 	ExplosionData *data = (ExplosionData*)&self->local_data;
 	
-	SpriteInfo *sinfo = (SpriteInfo*)self->renderables[0]->data;
+	SpriteInfo *sinfo = (SpriteInfo*)self->archetype->renderables[0]->data;
 	SpriteData *sdata = &data->sprite_data;
 	AnimateSprite(
 			sinfo,
@@ -178,6 +185,8 @@ ExplosionInfo_new(
 			.Render      = RenderBillboard,
 			.transparent = true,
 		};
+	info->archetype                = Explosion_Archetype;
+	info->archetype.renderables[0] = &info->renderable;
 
 	return info;
 }
@@ -213,7 +222,7 @@ Explosion_new(
 
 	info->renderable.Render = RenderBillboard;
 	
-	explosion->renderables[0]    = &info->renderable;
+	explosion->archetype         = &info->archetype;
 	explosion->visibility_radius = info->radius;
 	explosion->user_data         = info;
 	explosion->position          = position;
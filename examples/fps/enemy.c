@@ -52,9 +52,7 @@ EntityVTable enemyCallbacks = {
 	};
 
 Entity enemyTemplate = {
-		.renderables       = {NULL},
-		.lod_distances     = {256.0f},
-		.lod_count         = 1,
+		.archetype         = NULL, /* Set from the EnemyInfo */
 		.renderable_offset = {0.0f, 0.0f, 0.0f},
 		.visibility_radius = 1.75f,
 		.bounds            = {1.5f, 2.5f, 1.5f},
@@ -115,7 +113,7 @@ enemyRender(Entity *self, float delta)
 		tick_elapsed_val
 	);
 
-	AnimatedModel *anim_model = (AnimatedModel*)self->renderables[0]->data;
+	AnimatedModel *anim_model = (AnimatedModel*)self->archetype->renderables[0]->data;
 
 	if (0 <= self->current_anim && anim_model->animations) {
 		ModelAnimation *anim = &anim_model->animations[self->current_anim];
@@ -684,11 +682,15 @@ Enemy_new(
 	enemy->current_anim = -1;  // Not initialized yet
 	enemy->anim_frame = 0;
 
-	enemy->lod_count = info->num_renderables;
-	for (int i = 0; i < info->num_renderables; i++) {
-		enemy->renderables[i]   = &info->renderables[i];
-		enemy->lod_distances[i] = info->lod_distances[i];
+	EntityArchetype *archetype = &info->archetype;
+	if (!archetype->lod_count) {
+		archetype->lod_count = info->num_renderables;
+		for (int i = 0; i < info->num_renderables; i++) {
+			archetype->renderables[i]   = &info->renderables[i];
+			archetype->lod_distances[i] = info->lod_distances[i];
+		}
 	}
+	enemy->archetype = archetype;
 	
 	Thinker_init(&data->thinker);
 	data->prev_pos    = position;
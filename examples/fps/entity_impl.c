@@ -23,6 +23,13 @@ Renderable
 			.Render = testRenderableBoxCallback
 		};
 
+EntityArchetype entity_Archetype = {
+		.name          = "test_box",
+		.renderables   = {&r_1,  &r_2,  &r_3},
+		.lod_distances = {16.0f, 48.0f, 2048.0f},
+		.lod_count     = 3,
+	};
+
 EntityVTable entity_Callbacks = {
 		.Setup       = NULL,
 		.Enter       = NULL,
@@ -36,9 +43,7 @@ EntityVTable entity_Callbacks = {
 	};
 
 Entity entityTemplate = {
-		.renderables       = {&r_1,  &r_2,  &r_3},
-		.lod_distances     = {16.0f, 48.0f, 2048.0f},
-		.lod_count         = 3,
+		.archetype         = &entity_Archetype,
 		.renderable_offset = {0.0f, 0.5f, 0.0f},
 		.visibility_radius = 1.5f,
 		.bounds            = V3_ONE_INIT,
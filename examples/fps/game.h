@@ -194,6 +194,7 @@ typedef struct
 	Renderable      renderables[MAX_RENDERABLES_PER_ENTITY];
 	float           lod_distances[MAX_RENDERABLES_PER_ENTITY];
 	int             num_renderables;
+	EntityArchetype archetype; /* Built from the above by Enemy_new() */
 	ProjectileInfo *projectile_info; 
 	float
 					health,
@@ -129,27 +129,24 @@ runEngine(void *data, void *value)
 		);
 //	Entity_addToScene(grunt, scene);
  /*
-	Entity *ents[21][21][21];
-	int z = 0; 
+	Vector3 positions[21 * 21];
+	uint    num_ents = 0;
 
 	for (int x = 0; x < 21; x++) {
 		for (int y = 0; y < 21; y++) {
-			for (int z = 0; z < 1; z++) {
-				Vector3 position       = (Vector3){
-						.x = (x * 5.0f) - 50.0f,
-						.y = (z * 5.0f),
-						.z = (y * 5.0f) - 50.0
-					};
-				position.y = HeightmapScene_getHeight(scene, position);
-				DBG_OUT("Entity position.y: %.4f", position.y);
-				if (position.x == 0.0f && position.z == 0.0f) continue;
-				ents[x][y][z]           = Entity_new(&entityTemplate, scene, 0);
-				ents[x][y][z]->visible  = true;
-				ents[x][y][z]->active   = true;
-				ents[x][y][z]->position = position;
-			}
+			Vector3 position       = (Vector3){
+					.x = (x * 5.0f) - 50.0f,
+					.y = 0.0f,
+					.z = (y * 5.0f) - 50.0
+				};
+			position.y = HeightmapScene_getHeight(scene, position);
+			DBG_OUT("Entity position.y: %.4f", position.y);
+			if (position.x == 0.0f && position.z == 0.0f) continue;
+			positions[num_ents++] = position;
 		}
 	}
+	Entity **ents = Entity_newBatch(&entityTemplate, num_ents, positions, 0, scene);
+	DynamicArray_free(ents);
 	// */
 	DBG_OUT("Enemy entity created");
 
@@ -18,6 +18,14 @@ Renderable
 			.Render = NULL,//testRenderableBoxWiresCallback
 		};
 
+EntityArchetype
+player_Archetype = {
+		.name          = "player",
+		.renderables   = {&r_player},
+		.lod_distances = {1024.0f},
+		.lod_count     = 1,
+	};
+
 EntityVTable 
 player_Callbacks = {
 		.Setup       = playerSetup,
@@ -33,9 +41,7 @@ player_Callbacks = {
 
 Entity
 playerTemplate = {
-		.renderables       = {&r_player},
-		.lod_distances     = {1024.0f},
-		.lod_count         = 1,
+		.archetype         = &player_Archetype,
 		.visibility_radius = 4.5f,
 		.bounds            = {1.0f, 2.0f, 1.0f},
 		.bounds_offset     = {0.0f, 1.0f, 0.0f},
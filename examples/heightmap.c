@@ -67,6 +67,8 @@ Heightmap
 		      *colormap;
 	Vector3   *normalmap;
 	ChunkData *chunks;
+	float     *chunk_bounds;  /* Every wrapped copy of every chunk's center and extents, one array per component */
+	uint32    *chunk_visible; /* Bitmask over chunk_bounds, refilled per Head */
 	Texture2D
 		texture,
 		skybox_textures[6];
@@ -80,6 +82,7 @@ Heightmap;
 void            heightmapSceneSetup(    Scene *scene, void   *map_data);
 void            heightmapScenePreRender(Scene *scene, Head   *head);
 void            heightmapSceneRender(   Scene *scene, Head   *head);
+void            heightmapSceneSubmit(   Scene *scene, Renderer *renderer);
 CollisionResult heightmapSceneCollision(Scene *scene, Entity *entity,   Vector3 to);
 CollisionResult heightmapSceneRaycast(  Scene *scene, Vector3 from,     Vector3 to);
 void            heightmapSceneFree(     Scene *scene);
@@ -99,6 +102,7 @@ SceneVTable heightmap_Scene_Callbacks = {
 	.Raycast        = heightmapSceneRaycast,
 	.PreRender      = heightmapScenePreRender,
 	.Render         = heightmapSceneRender, 
+	.Submit         = heightmapSceneSubmit,
 	.Exit           = NULL, 
 	.Free           = heightmapSceneFree,
 };
@@ -915,6 +919,42 @@ generateChunks(Heightmap *map)
 	return chunks;
 }
 
+/* Lay out all 9 wrapped copies of each chunk for cullAABBsInFrustum(); they never move */
+void
+packChunkBounds(Heightmap *map)
+{
+	size_t num_chunks = map->data.chunks_wide * map->data.chunks_wide;
+	size_t count      = num_chunks * 9;
+
+	map->chunk_bounds  = malloc(count * 6 * sizeof(float));
+	map->chunk_visible = malloc(FRUSTUM_MASK_WORDS(count) * sizeof(uint32));
+
+	float
+		*x        = map->chunk_bounds,
+		*y        = x + count,
+		*z        = y + count,
+		*extent_x = z + count,
+		*extent_y = extent_x + count,
+		*extent_z = extent_y + count;
+
+	for (size_t i = 0; i < num_chunks; i++) {
+		ChunkData *chunk = &map->chunks[i];
+
+		for (int offset_x = -1; offset_x <= 1; offset_x++) {
+			for (int offset_z = -1; offset_z <= 1; offset_z++) {
+				size_t wrap = i * 9 + (offset_x + 1) * 3 + (offset_z + 1);
+
+				x[wrap]        = chunk->position.x + offset_x * map->world_size;
+				y[wrap]        = chunk->position.y;
+				z[wrap]        = chunk->position.z + offset_z * map->world_size;
+				extent_x[wrap] = chunk->bounds.x * 0.5f;
+				extent_y[wrap] = chunk->bounds.y * 0.5f;
+				extent_z[wrap] = chunk->bounds.z * 0.5f;
+			}
+		}
+	}
+}
+
 
 /**********************
 	SCENE CALLBACKS
@@ -935,6 +975,7 @@ heightmapSceneSetup(Scene *scene, void *map_data)
 	map->colormap  = generateColorMap(map);
 	LoadingScreen_draw(50, "Generating Terrain Chunks...");
 	map->chunks    = generateChunks(map);
+	packChunkBounds(map);
 
 	if (data->texture_path) {
 		LoadingScreen_draw(60, data->texture_path);
@@ -1034,12 +1075,28 @@ heightmapSceneRender(Scene *scene, Head *head)
 			DrawCubeWires((Vector3){ 0.0f,       data->height_scale, -half_width}, 5.0f, 5.0f, 5.0f, BLUE);
 		);
 //*/
+	/* Frustum cull every wrapped copy of every chunk at once */
+	size_t  wrap_count = num_chunks * 9;
+	float  *bounds     = map->chunk_bounds;
+	cullAABBsInFrustum(
+			Head_getFrustum(head),
+			bounds,
+			bounds + wrap_count,
+			bounds + wrap_count * 2,
+			bounds + wrap_count * 3,
+			bounds + wrap_count * 4,
+			bounds + wrap_count * 5,
+			wrap_count,
+			map->chunk_visible
+		);
+	
 	for (size_t i = 0; i < num_chunks; i++) {
 		ChunkData *chunk   = &map->chunks[i];
 
 		float 
-			chunk_pos_x = chunk->position.x,
-			chunk_half  = (data->chunk_cells * data->cell_size) * 0.5f;
+			chunk_pos_x    = chunk->position.x,
+			chunk_half     = (data->chunk_cells * data->cell_size) * 0.5f,
+			max_dist_check = max_distance + Vector3Length(Vector3Scale(chunk->bounds, 0.5f));
 
 		int 
 			start_x = chunk->idx.x * data->chunk_cells,
@@ -1060,13 +1117,14 @@ heightmapSceneRender(Scene *scene, Head *head)
 			{chunk_pos_x + chunk_half, heightmap[end_z][end_x]     * data->height_scale + data->offset, chunk->position.z + chunk_half}
 		};
 		
-		Frustum *frustum      = Head_getFrustum(head);
 //*/
 		// Check all possible wrap positions (including original at 0,0)
 		for (int offset_x = -1; offset_x <= 1; offset_x++) {
 			for (int offset_z = -1; offset_z <= 1; offset_z++) {
 				Vector3 wrap_offset = {offset_x * world_size, 0, offset_z * world_size};
-				Vector3 test_pos = Vector3Add(chunk->position, wrap_offset);
+				size_t  wrap        = i * 9 + (offset_x + 1) * 3 + (offset_z + 1);
+				
+				if (!(map->chunk_visible[wrap / 32] & (1u << (wrap % 32)))) continue;
 				
 				// Calculate distance for this wrap position
 				float test_dist_sq = INFINITY;
@@ -1079,15 +1137,8 @@ heightmapSceneRender(Scene *scene, Head *head)
 					if (d < test_dist_sq) test_dist_sq = d;
 				}
 				
-				// Frustum cull and render if visible
-				if (isAABBInFrustum(
-						test_pos,
-						Vector3Scale(chunk->bounds, 0.5f),
-						frustum,
-						test_dist_sq,
-						max_distance
-					)
-				) {
+				// Distance cull and render if visible
+				if (test_dist_sq <= max_dist_check * max_dist_check) {
 					if (offset_x != 0 || offset_z != 0) {
 						rlPushMatrix();
 						rlTranslatef(wrap_offset.x, wrap_offset.y, wrap_offset.z);
@@ -1104,23 +1155,22 @@ heightmapSceneRender(Scene *scene, Head *head)
 		}
 		
 	}
-	Entity **entities = Scene_getEntities(scene);
+	Entity **entities = Scene_getRenderEntities(scene);
 	
 	for (size_t i = 0; i < DynamicArray_length(entities); i++) {
-		Entity *entity = entities[i];
-		
-		// Always submit at actual position
-		Renderer_submitEntity(renderer, entity);
+		Entity  *entity     = entities[i];
+		Vector3  entity_pos = Entity_getRenderTransform(entity).translation;
 		
+		// The actual position is submitted once for every Head in heightmapSceneSubmit()
 		// Check all 8 possible wrap positions
 		for (int ox = -1; ox <= 1; ox++) {
 			for (int oz = -1; oz <= 1; oz++) {
 				if (ox == 0 && oz == 0) continue;
 				
 				Vector3 test_pos = {
-					entity->position.x + (ox * world_size),
-					entity->position.y,
-					entity->position.z + (oz * world_size)
+					entity_pos.x + (ox * world_size),
+					entity_pos.y,
+					entity_pos.z + (oz * world_size)
 				};
 				
 				float 
@@ -1129,11 +1179,7 @@ heightmapSceneRender(Scene *scene, Head *head)
 					dist_sq = dx*dx + dz*dz;
 				
 				if (dist_sq < max_distance * max_distance) {
-					Vector3 orig = entity->position;
-					entity->position = test_pos;
-					
-					Renderer_submitEntity(renderer, entity);
-					entity->position = orig;
+					Renderer_submitEntityAt(renderer, entity, test_pos);
 				}
 			}
 		}
@@ -1141,6 +1187,18 @@ heightmapSceneRender(Scene *scene, Head *head)
 }
 
 
+void
+heightmapSceneSubmit(Scene *scene, Renderer *renderer)
+{
+	Entity **entities = Scene_getRenderEntities(scene);
+	
+	for (size_t i = 0; i < DynamicArray_length(entities); i++) {
+		Entity *entity = entities[i];
+		Renderer_submitEntityAt(renderer, entity, Entity_getRenderTransform(entity).translation);
+	}
+}
+
+
 CollisionResult
 heightmapSceneCollision(Scene *scene, Entity *entity, Vector3 to)
 {
@@ -1381,6 +1439,8 @@ heightmapSceneFree(Scene *scene)
 	DynamicArray_free(map->normalmap);
 	DynamicArray_free(map->chunks);
 	DynamicArray_free(map->heightmap);
+	free(map->chunk_bounds);
+	free(map->chunk_visible);
 }
 
 
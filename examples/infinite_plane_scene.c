@@ -11,6 +11,7 @@
 */
 void            infinitePlaneSceneSetup(    Scene *scene, void   *map_data);
 void            infinitePlaneSceneRender(   Scene *scene, Head   *head);
+void            infinitePlaneSceneSubmit(   Scene *scene, Renderer *renderer);
 CollisionResult infinitePlaneSceneCollision(Scene *scene, Entity *entity,   Vector3 to);
 CollisionResult infinitePlaneSceneRaycast(  Scene *scene, Vector3 from,     Vector3 to);
 void            infinitePlaneSceneFree(     Scene *scene);
@@ -31,6 +32,7 @@ SceneVTable infinite_Plane_Scene_Callbacks = {
 	.Raycast        = infinitePlaneSceneRaycast,
 	.PreRender      = NULL,
 	.Render         = infinitePlaneSceneRender, 
+	.Submit         = infinitePlaneSceneSubmit,
 	.Exit           = NULL, 
 	.Free           = infinitePlaneSceneFree,
 };
@@ -76,12 +78,16 @@ infinitePlaneSceneSetup(Scene *scene, void *map_data)
 void
 infinitePlaneSceneRender(Scene *scene, Head *head)
 {
-	Renderer *renderer = Engine_getRenderer(Scene_getEngine(scene));
-	Camera   *camera   = Head_getCamera(head);
+	Camera *camera = Head_getCamera(head);
 #ifndef ON_CONSOLE
 	//DrawGrid(100, 1.0f);
 #endif
 	DrawInfinitePlane(camera, 1.0f);
+}
+
+void
+infinitePlaneSceneSubmit(Scene *scene, Renderer *renderer)
+{
 	EntityList *ent_list = Scene_getEntities(scene);
 	for (size_t i = 0; i < ent_list->count; i++) {
 		Renderer_submitEntity(renderer, ent_list->entities[i]);
@@ -20,8 +20,9 @@
 typedef struct
 LightningBeamInfo
 {
-	RibbonInfo *ribbon_info;
-	Renderable  renderable;
+	RibbonInfo     *ribbon_info;
+	Renderable      renderable;
+	EntityArchetype archetype;
 }
 LightningBeamInfo;
 
@@ -56,6 +57,14 @@ lightning_Renderable = {
 		.transparent = true,
 	};
 
+static EntityArchetype
+LightningBeam_Archetype = {
+		.name          = "lightning_beam",
+		.renderables   = {&lightning_Renderable},
+		.lod_distances = {2048.0f},
+		.lod_count     = 1,
+	};
+
 static EntityVTable
 LightningBeam_Callbacks = {
 		.Setup       = NULL,
@@ -70,9 +79,7 @@ LightningBeam_Callbacks = {
 
 static Entity
 LightningBeam_Template = {
-		.renderables       = {&lightning_Renderable},
-		.lod_distances     = {2048.0f},
-		.lod_count         = 1,
+		.archetype         = &LightningBeam_Archetype,
 		.visibility_radius = 0.5f,
 		.bounds            = {0.05f, 0.05f, 0.05f},
 		.bounds_offset     = {0.0f,  0.0f,  0.0f},
@@ -171,6 +178,8 @@ LightningBeamInfo_new(
 			.Render      = RenderRibbon,
 			.transparent = true,
 		};
+	info->archetype                = LightningBeam_Archetype;
+	info->archetype.renderables[0] = &info->renderable;
 
 	return info;
 }
@@ -213,7 +222,7 @@ LightningBeam_new(
             .flip_v        = false,
 		};
 
-	beam->renderables[0]    = &info->renderable;
+	beam->archetype         = &info->archetype;
 	beam->user_data         = info;
 	beam->position          = Vector3Add(muzzle, Vector3Scale(diff, 0.5f));
 	beam->visibility_radius = length * 0.5f + 1.0f;
@@ -928,7 +928,7 @@ mapscene_RenderMap(Scene *scene, Head *head)
         }
     }
 
-    Entity **entities = Scene_getEntities(scene);
+    Entity **entities = Scene_getRenderEntities(scene);
     for (size_t i = 0; i < DynamicArray_length(entities); i++)
         Renderer_submitEntity(renderer, entities[i]);
 }
@@ -1069,7 +1069,7 @@ mapscene_RenderBSP(Scene *scene, Head *head)
 
 submit_entities:
     {
-        Entity **entities = Scene_getEntities(scene);
+        Entity **entities = Scene_getRenderEntities(scene);
         for (size_t i = 0; i < DynamicArray_length(entities); i++)
             Renderer_submitEntity(renderer, entities[i]);
     }
@@ -23,6 +23,7 @@ ProjectileInfo
 	};
 	ProjectileMotion    motion;
 	Renderable          renderable;
+	EntityArchetype     archetype;
 	ProjectileCollision Collision;
 	ProjectileTimeout   Timeout;
 }
@@ -37,6 +38,7 @@ static void projectileSetup(    Entity *self);
 static void projectileUpdate(   Entity *self, float           delta);
 static void projectileRender(   Entity *self, float           delta);
 static void projectileCollision(Entity *self, CollisionResult collision);
+static void projectileRestore(  Entity *self);
 
 
 /*
@@ -52,13 +54,20 @@ projectile_Callbacks = {
 	.OnCollided  = projectileCollision,
 	.Exit        = NULL,
 	.Free        = NULL,
+	.Restore     = projectileRestore,
+};
+
+static EntityArchetype
+projectile_archetype = {
+	.name          = "projectile",
+	.renderables   = {NULL},
+	.lod_distances = {1024.0f},
+	.lod_count     = 1,
 };
 
 static Entity
 projectile_template = {
-	.renderables       = {NULL},
-	.lod_distances     = {1024.0f},
-	.lod_count         = 1,
+	.archetype         = &projectile_archetype,
 	.visibility_radius = 0.25f,
 	.bounds            = {0.1f, 0.1f, 0.1f},
 	.bounds_offset     = {0.0f, 0.0f, 0.0f},
@@ -204,8 +213,9 @@ projectileRender(Entity *self, float delta)
 	// Combine: first align, then spin around that new forward axis
 	self->orientation   = QuaternionMultiply(spin, align);
 
-	if (self->renderables[0]->Render == RenderBillboard) {
-		SpriteInfo *sinfo = (SpriteInfo*)self->renderables[0]->data;
+	Renderable *renderable = self->archetype->renderables[0];
+	if (renderable->Render == RenderBillboard) {
+		SpriteInfo *sinfo = (SpriteInfo*)renderable->data;
 		SpriteData *sdata = &data->sprite_data;
 		AnimateSprite(
 				sinfo,
@@ -215,6 +225,17 @@ projectileRender(Entity *self, float delta)
 	}
 }
 
+/* Source or target may have come back from a snapshot somewhere else */
+static void
+projectileRestore(Entity *self)
+{
+	ProjectileData *data  = (ProjectileData*)self->local_data;
+	Scene          *scene = Entity_getScene(self);
+	
+	data->source = Scene_relocateEntity(scene, data->source);
+	data->target = Scene_relocateEntity(scene, data->target);
+}
+
 static void 
 projectileCollision(Entity *self, CollisionResult collision)
 {
@@ -261,6 +282,9 @@ ProjectileInfo_new(
 	info->renderable = *renderable;
 	info->Collision  =  Collision_Callback;
 	info->Timeout    =  Timeout_Callaback;
+	
+	info->archetype                = projectile_archetype;
+	info->archetype.renderables[0] = &info->renderable;
 
 	return info;
 }
@@ -304,7 +328,7 @@ Projectile_new(
 	memcpy(data->data, pdata, pdata_size);
 
 	projectile->user_data      = info;
-	projectile->renderables[0] = &info->renderable;
+	projectile->archetype      = &info->archetype;
 	projectile->position       = position;
 	projectile->visible        = true;
 	projectile->active         = true;
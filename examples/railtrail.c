@@ -19,7 +19,8 @@ RailTrailInfo
 {
 	float       scroll_speed;
 	RibbonInfo *ribbon_info;
-	Renderable  renderable;
+	Renderable      renderable;
+	EntityArchetype archetype;
 }
 RailTrailInfo;
 
@@ -49,6 +50,14 @@ rail_Renderable = {
 		.transparent = true,
 	};
 
+static EntityArchetype
+RailTrail_Archetype = {
+		.name          = "rail_trail",
+		.renderables   = {&rail_Renderable},
+		.lod_distances = {2048.0f},
+		.lod_count     = 1,
+	};
+
 static EntityVTable
 RailTrail_Callbacks = {
 		.Setup       = NULL,
@@ -63,9 +72,7 @@ RailTrail_Callbacks = {
 
 static Entity
 RailTrail_Template = {
-		.renderables       = {&rail_Renderable},
-		.lod_distances     = {2048.0f},
-		.lod_count         = 1,
+		.archetype         = &RailTrail_Archetype,
 		.visibility_radius = 0.5f,
 		.bounds            = {0.05f, 0.05f, 0.05f},
 		.bounds_offset     = {0.0f,  0.0f,  0.0f},
@@ -163,6 +170,8 @@ RailTrailInfo_new(
 			.Render      = RenderRibbon,
 			.transparent = true,
 		};
+	info->archetype                = RailTrail_Archetype;
+	info->archetype.renderables[0] = &info->renderable;
 
 	return info;
 }
@@ -207,8 +216,8 @@ RailTrail_new(
     
 	/* ---- Wire the renderable -------------------------------------- */
 
-	trail->renderables[0] = &info->renderable;
-	trail->user_data      = info;
+	trail->archetype = &info->archetype;
+	trail->user_data = info;
 
 	/* ---- Position at midpoint for frustum culling ----------------- */
 	trail->position          = Vector3Add(muzzle, Vector3Scale(diff, 0.5f));
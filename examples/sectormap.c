@@ -33,6 +33,8 @@ void            SectorMapScene_setup(      Scene *scene, void    *map_data);
 void            SectorMapScene_entityEnter(Scene *scene, Entity  *entity);
 void            SectorMapScene_entityExit( Scene *scene, Entity  *entity);
 void            SectorMapScene_render(     Scene *scene, Head    *head);
+void            SectorMapScene_submit(     Scene *scene, Renderer *renderer);
+void            SectorMapScene_drawOccluders(Scene *scene, Head *head, OcclusionBuffer *buffer);
 CollisionResult SectorMapScene_collision(  Scene *scene, Entity  *entity,  Vector3 to);
 CollisionResult SectorMapScene_raycast(    Scene *scene, Vector3  from,    Vector3 to);
 void            SectorMapScene_free(       Scene *scene);
@@ -51,6 +53,8 @@ SceneVTable sectormap_Scene_Callbacks = {
     .Raycast        = SectorMapScene_raycast,
     .PreRender      = NULL,
     .Render         = SectorMapScene_render,
+    .Submit         = SectorMapScene_submit,
+    .DrawOccluders  = SectorMapScene_drawOccluders,
     .Exit           = NULL,
     .Free           = SectorMapScene_free,
 };
@@ -741,7 +745,6 @@ SectorMapScene_render(Scene *scene, Head *head)
     SectorMapInternal *internal     = Scene_getData(scene);
     SectorMap         *map          = &internal->map;
     Camera            *camera       = Head_getCamera(head);
-    Renderer          *renderer     = Engine_getRenderer(Scene_getEngine(scene));
     Vector2            cam2d        = { camera->position.x, camera->position.z };
     size_t             sector_count = DynamicArray_length(map->sectors);
 
@@ -800,14 +803,48 @@ SectorMapScene_render(Scene *scene, Head *head)
             RenderWall(map, wall, sector);
         }
     }
+}
 
-    /* Render Entities */
-    Entity **ent_list  = Scene_getEntities(scene);
-    size_t   ent_count = Scene_getEntityCount(scene);
+/* Entities don't depend on the Head, so they're submitted once for all of them */
+void
+SectorMapScene_submit(Scene *scene, Renderer *renderer)
+{
+    Entity **ent_list  = Scene_getRenderEntities(scene);
+    size_t   ent_count = Scene_getRenderEntityCount(scene);
     for (size_t i = 0; i < ent_count; i++)
         Renderer_submitEntity(renderer, ent_list[i]);
 }
 
+/* Solid walls hide whatever is behind them, from every Head */
+void
+SectorMapScene_drawOccluders(Scene *scene, Head *head, OcclusionBuffer *buffer)
+{
+    (void)head;
+    SectorMapInternal *internal = Scene_getData(scene);
+    SectorMap         *map      = &internal->map;
+
+    for (size_t s = 0; s < DynamicArray_length(map->sectors); s++) {
+        Sector *sector = &map->sectors[s];
+
+        for (size_t i = sector->wall_start; i < sector->wall_start + sector->wall_count; i++) {
+            Wall *wall = &map->walls[i];
+            if (wall->next_sector != SECTOR_NONE) continue;
+
+            Vector2
+                a2d = map->vertices[wall->verts[0]],
+                b2d = map->vertices[wall->verts[1]];
+
+            OcclusionBuffer_drawQuad(
+                buffer,
+                (Vector3){ a2d.x, sector->floor_z,   a2d.y },
+                (Vector3){ b2d.x, sector->floor_z,   b2d.y },
+                (Vector3){ b2d.x, sector->ceiling_z, b2d.y },
+                (Vector3){ a2d.x, sector->ceiling_z, a2d.y }
+            );
+        }
+    }
+}
+
 /*********************
     PUBLIC METHODS
 *********************/
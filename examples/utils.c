@@ -59,15 +59,11 @@ RenderModel(
     (void)camera;
 	Model  *model  = (Model*)renderable->data;
 	Entity *entity = (Entity*)render_data;
-	Vector3          
-		    pos    = Vector3Add(position, entity->renderable_offset),
-		    scale  = entity->scale;
-	Matrix  matrix = QuaternionToMatrix(entity->orientation);
+	/* Same interpolated matrix as an instanced draw, never the live Entity */
+	Matrix  matrix = Entity_getInstanceTransform(entity, position);
 	
 	rlPushMatrix();
-		rlTranslatef(pos.x, pos.y, pos.z);
 		rlMultMatrixf(MatrixToFloat(matrix));
-		rlScalef(scale.x, scale.y, scale.z);
 		
 		DrawModel(
 				*model,
@@ -78,6 +74,32 @@ RenderModel(
 	rlPopMatrix();
 }
 
+/*
+	Instanced counterpart of RenderModel(). The model's material shaders
+	must take the model matrix as a per-instance attribute, as in raylib's
+	instancing example; leave RenderInstanced unset for ones that don't.
+*/
+void
+RenderModelInstanced(
+	Renderable   *renderable,
+	const Matrix *transforms,
+	uint          count,
+	Camera3D     *camera
+)
+{
+    (void)camera;
+	Model *model = (Model*)renderable->data;
+	
+	for (int i = 0; i < model->meshCount; i++) {
+		DrawMeshInstanced(
+				model->meshes[i],
+				model->materials[model->meshMaterial[i]],
+				transforms,
+				count
+			);
+	}
+}
+
 void
 RenderAnimatedModel(
 	Renderable *renderable,
@@ -97,52 +119,49 @@ RenderAnimatedModel(
 	DBG_OUT("Model bone count: %d", anim_model->model.boneCount);
 	DBG_OUT("Model mesh count: %d", anim_model->model.meshCount);
 	
-	Vector3          
-		    pos               = Vector3Add(position, entity->renderable_offset),
-		    scale             = entity->scale;
-	Matrix  matrix            = QuaternionToMatrix(entity->orientation);
+	Matrix  matrix            = Entity_getInstanceTransform(entity, position);
+	int     anim_frame;
+	int     current_anim      = Entity_getRenderAnimation(entity, &anim_frame);
 	
 	if (
-		entity->current_anim < 0 
-		|| entity->current_anim >= anim_model->anim_count
+		current_anim < 0 
+		|| current_anim >= anim_model->anim_count
 	) {
 		DBG_OUT(
 				"Invalid anim: %d (max %d)", 
-				entity->current_anim, 
+				current_anim, 
 				anim_model->anim_count
 			);
 		/* Just draw without animation */
 		goto DRAW_ONLY;
 	}
 	if (
-		0 <= entity->current_anim 
+		0 <= current_anim 
 		&& anim_model->animations
 	) {
-		ModelAnimation *anim  = &anim_model->animations[entity->current_anim];
-		int             frame = entity->anim_frame % anim->frameCount;
+		ModelAnimation *anim  = &anim_model->animations[current_anim];
+		int             frame = anim_frame % anim->frameCount;
 		if (frame < 0) frame = 0;
 		
 		DBG_OUT("Animation bone count: %d", anim->boneCount);
 		DBG_OUT("Animation frame count: %d", anim->frameCount);
 		DBG_OUT(
 				"Updating animation %d, frame %d/%d", 
-				entity->current_anim, frame, 
+				current_anim, frame, 
 				anim->frameCount
 			);
 		
 		UpdateModelAnimation(
 			anim_model->model,
 			*anim,
-			entity->anim_frame
+			anim_frame
 		);
 //*/
 	}
 	
 DRAW_ONLY:
 	rlPushMatrix();
-		rlTranslatef(pos.x, pos.y, pos.z);
 		rlMultMatrixf(MatrixToFloat(matrix));
-		rlScalef(scale.x, scale.y, scale.z);
 		
 		DrawModel(
 				anim_model->model,
@@ -165,9 +184,11 @@ testRenderableBoxCallback(
 	Entity *entity = render_data;
 	Color  *color  = (Color*)renderable->data;
 	if (!color) return;
+	/* Bounds are axis aligned, so only the translation applies */
+	Matrix  matrix = Entity_getInstanceTransform(entity, position);
 	DrawCubeV(
-		Vector3Add(position, entity->renderable_offset),
-		entity->bounds,
+		(Vector3){matrix.m12, matrix.m13, matrix.m14},
+		Entity_getRenderBounds(entity),
 		*color
 	);
 		
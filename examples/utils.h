@@ -23,6 +23,14 @@ RenderModel(
 	Camera3D   *camera
 );
 
+void
+RenderModelInstanced(
+	Renderable   *renderable,
+	const Matrix *transforms,
+	uint          count,
+	Camera3D     *camera
+);
+
 void
 RenderAnimatedModel(
 	Renderable *renderable,
@@ -36,10 +36,37 @@
 /****************
 	CONSTANTS
 ****************/
+/* Platform-related settings */
+#if defined(__PSP__) || defined(__DREAMCAST__)
+	#ifndef KOLIBRI_NO_THREADS
+		/* No threads: jobs run inline on the calling thread */
+		#define KOLIBRI_NO_THREADS 1
+	#endif
+#endif
 /* Engine-related constants */
 #ifndef MAX_NUM_HEADS
 	#define MAX_NUM_HEADS 4
 #endif
+#ifndef ENGINE_SPIN_MARGIN
+	/* Seconds before a tick that a headless Engine stops sleeping and spins */
+	#define ENGINE_SPIN_MARGIN 0.001
+#endif
+#ifndef ENGINE_MAX_SUBSTEPS
+	/* Most ticks run in one frame to catch up; 0 for no limit */
+	#define ENGINE_MAX_SUBSTEPS 8
+#endif
+#ifndef ENGINE_MAX_CATCH_UP_TIME
+	/* Most seconds the simulation may fall behind before the rest is dropped */
+	#define ENGINE_MAX_CATCH_UP_TIME 0.25f
+#endif
+#ifndef ENGINE_OVERLOAD_FRAMES
+	/* Overloaded frames in a row before an adaptive tick rate is lowered */
+	#define ENGINE_OVERLOAD_FRAMES 30
+#endif
+#ifndef ENGINE_JOB_THREADS
+	/* Threads for the Engine's JobSystem; 0 uses one per CPU */
+	#define ENGINE_JOB_THREADS 0
+#endif
 #ifdef ENGINE_SINGLE_HEAD_ONLY
 	/*
 		If defined, only the first head can and will be used for rendering, and
@@ -55,7 +82,11 @@
 	#define DEFAULT_MAX_ENTITIES_PER_FRAME 1024
 #endif
 #ifndef DEFAULT_RENDER_FLAGS
-	#define DEFAULT_RENDER_FLAGS 7
+	#define DEFAULT_RENDER_FLAGS 15
+#endif
+#ifndef DEFAULT_LOD_PIXEL_ERROR
+	/* 0 picks LODs by distance alone */
+	#define DEFAULT_LOD_PIXEL_ERROR 0.0f
 #endif
 #ifdef HEAD_USE_RENDER_TEXTURE
 	/* 
@@ -69,6 +100,20 @@
 #ifndef MAX_LOD_LEVELS
 	#define MAX_LOD_LEVELS 4
 #endif
+#ifndef LOD_HYSTERESIS
+	/* Fraction of a LOD distance to overshoot before switching levels */
+	#define LOD_HYSTERESIS 0.1f
+#endif
+#ifndef LOD_REFERENCE_HEIGHT
+	/*
+		The view LOD distances are tuned for under screen-space LOD: this many
+		pixels tall at LOD_REFERENCE_FOVY, tolerating one pixel of error.
+	*/
+	#define LOD_REFERENCE_HEIGHT 720.0f
+#endif
+#ifndef LOD_REFERENCE_FOVY
+	#define LOD_REFERENCE_FOVY 60.0f
+#endif
 #ifndef MAX_RENDERABLES_PER_ENTITY  
 	#define MAX_RENDERABLES_PER_ENTITY 4
 #endif
@@ -76,6 +121,54 @@
 #ifndef MAX_NUM_ENTITIES
 	#define MAX_NUM_ENTITIES 4096
 #endif
+#ifndef UPDATE_LOD_LEVELS
+	/* Entity update buckets: bucket N is updated every 2^N ticks */
+	#define UPDATE_LOD_LEVELS 4
+#endif
+#ifndef DEFAULT_UPDATE_LOD_DISTANCE
+	/* Max distance of bucket 0; each following bucket doubles it */
+	#define DEFAULT_UPDATE_LOD_DISTANCE 64.0f
+#endif
+/* Job system-related constants */
+#ifndef JOB_POOL_SIZE
+	/* Max jobs in flight at once. Must be a power of two */
+	#define JOB_POOL_SIZE 4096
+#endif
+#ifndef JOB_MAX_DEPENDENTS
+	#define JOB_MAX_DEPENDENTS 8
+#endif
+#ifndef JOB_MAX_THREADS
+	#define JOB_MAX_THREADS 64
+#endif
+#ifndef SCENE_UPDATE_BATCH_SIZE
+	/* Entities handed to a thread at a time during a parallel Scene update */
+	#define SCENE_UPDATE_BATCH_SIZE 64
+#endif
+/* Profiler-related constants */
+#ifndef PROFILER_MAX_ZONES
+	/* Must be a power of two */
+	#define PROFILER_MAX_ZONES 128
+#endif
+#ifndef PROFILER_HISTORY
+	/* Frames of history kept per zone for min/avg/max */
+	#define PROFILER_HISTORY 120
+#endif
+#ifndef PROFILER_EVENT_BUFFER_SIZE
+	/* Zone events kept per thread for the trace dump. Must be a power of two */
+	#define PROFILER_EVENT_BUFFER_SIZE 16384
+#endif
+#ifndef PROFILER_MAX_THREADS
+	#define PROFILER_MAX_THREADS 64
+#endif
+/* Replication-related constants */
+#ifndef REPLICATION_POSITION_SCALE
+	/* Steps per unit positions are quantised to */
+	#define REPLICATION_POSITION_SCALE 256.0f
+#endif
+#ifndef REPLICATION_ORIENTATION_BITS
+	/* Per component of a smallest-three quaternion; at most 10 */
+	#define REPLICATION_ORIENTATION_BITS 10
+#endif
 /* Collision system-related constants */
 #ifndef SPATIAL_HASH_SIZE
 	/* Should be a prime number */
@@ -90,8 +183,23 @@
 #ifndef ENTRY_POOL_SIZE
 	#define ENTRY_POOL_SIZE 8192
 #endif
-#ifndef VIS_QUERY_SIZE
-	#define VIS_QUERY_SIZE 4096
+#ifndef CULL_OCTREE_SIZE
+	/* Half the width of the Renderer's culling octree's root cell */
+	#define CULL_OCTREE_SIZE 4096.0f
+#endif
+#ifndef OCTREE_MAX_DEPTH
+	#define OCTREE_MAX_DEPTH 8
+#endif
+#ifndef OCTREE_QUERY_SLOTS
+	/* Viewers, e.g. Heads, a LooseOctree remembers each item's last result for */
+	#define OCTREE_QUERY_SLOTS MAX_NUM_HEADS
+#endif
+#ifndef OCCLUSION_BUFFER_WIDTH
+	/* Resolution of each Head's software depth buffer for occlusion culling */
+	#define OCCLUSION_BUFFER_WIDTH 256
+#endif
+#ifndef OCCLUSION_BUFFER_HEIGHT
+	#define OCCLUSION_BUFFER_HEIGHT 128
 #endif
 #ifndef COL_QUERY_SIZE
 	#define COL_QUERY_SIZE 128
@@ -189,7 +297,10 @@
 typedef struct Engine      Engine;
 typedef struct Entity      Entity;
 typedef struct Head        Head;
+typedef struct JobSystem   JobSystem;
+typedef struct OcclusionBuffer OcclusionBuffer;
 typedef struct Renderer    Renderer;
+typedef struct Replay      Replay;
 typedef struct Scene       Scene;
 typedef struct SpatialHash SpatialHash;
 
@@ -399,7 +510,14 @@ typedef struct
 Renderable
 {
     void  *data;
+	/*
+		For an Entity, data is the Entity itself. While pipelined the next
+		tick is changing it, so read it only through Entity_getInstanceTransform()
+		and the other Entity_getRender*() getters, never its fields directly.
+	*/
     void (*Render)(struct Renderable *renderable, void *data, Vector3 position, Camera3D *camera);
+	/* Optional; draws every visible opaque user of this Renderable at once, one model matrix each */
+	void (*RenderInstanced)(struct Renderable *renderable, const Matrix *transforms, uint count, Camera3D *camera);
 	union {
 		uint8 flags;
 		struct {
@@ -413,6 +531,7 @@ Renderable
 			bool flag_7     :1;
 		};
 	};
+	uint16 material; /* Optional; opaque draws sharing one are grouped together */
 } 
 Renderable;
 /*
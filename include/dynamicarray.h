@@ -30,6 +30,10 @@ void    DynamicArray_delete(   void    *array,  size_t   index, size_t length);
 void    DynamicArray_insert(   void   **array,  size_t   index, void   *data,   size_t length);
 size_t  DynamicArray_length(   void    *array);
 void    DynamicArray_replace(  void   **array,  size_t   index, void   *data,   size_t length);
+void    DynamicArray_reserve(  void   **array,  size_t   capacity);
+void    DynamicArray_truncate( void    *array,  size_t   length);
+
+size_t  DynamicArray_getAllocationCount(void);
 
 
 #endif /* BTCHWRK_DYNAMIC_ARRAY_H */
@@ -7,6 +7,7 @@
 typedef void (*EngineCallback)(      Engine *engine);
 typedef void (*EngineUpdateCallback)(Engine *engine, float delta);
 typedef void (*EngineResizeCallback)(Engine *engine, uint width, uint height);
+typedef void (*EngineInputCallback)( Engine *engine, void *input);
 
 typedef struct
 EngineVTable
@@ -14,7 +15,7 @@ EngineVTable
     EngineCallback       Setup;   /* Called upon creating a new Engine */
     EngineCallback       Run;     /* Called at the beginning of Engine_run() */
     EngineUpdateCallback Update;  /* Called once every frame before updating everything */
-    EngineUpdateCallback Tick;    /* Called once every tick before updating the scene */
+    EngineUpdateCallback Tick;    /* Called once every tick, with the tick length, before updating the scene */
     EngineCallback       Render;  /* Called once every frame after rendering the scene */
     EngineResizeCallback Resize;  /* Called upon window resize */
     EngineCallback       Pause;   /* Called on pausing the Engine */
@@ -25,6 +26,40 @@ EngineVTable
 EngineVTable;
 
 
+/*
+	EngineStats
+		Counters filled in by each subsystem over one frame. Engine_getStats()
+		returns the last finished frame's.
+*/
+typedef struct
+EngineStats
+{
+	uint64 frame;
+	uint
+	       ticks,
+	       dropped_ticks,
+	       entity_count,
+	       entities_updated,      /* Due an Update this frame, over all ticks */
+	       broadphase_entries,    /* Spatial hash entries after the last rebuild */
+	       broadphase_cells,      /* Buckets in use */
+	       broadphase_max_chain,  /* Longest bucket */
+	       broadphase_queries,
+	       pairs_tested,          /* Narrowphase tests run on broadphase candidates */
+	       narrowphase_hits,
+	       raycasts,
+	       renderables_submitted, /* Summed over every Head */
+	       renderables_culled,
+	       renderables_occluded,  /* Of those culled, hidden behind occluders */
+	       renderables_dropped,   /* Of those culled, Entities past a Head's max_entities_per_frame */
+	       renderables_drawn,
+	       transparent_sorted,
+	       render_state_changes,  /* Between consecutive opaque draws */
+	       instanced_batches,     /* RenderInstanced() calls */
+	       allocations;           /* Entities and DynamicArray (re)allocations */
+}
+EngineStats;
+
+
 /*
 	CONSTRUCTOR/DESTRUCTOR
 */
@@ -36,17 +71,32 @@ void    Engine_free(Engine       *engine);
 */
 float         Engine_getDeltaTime(  Engine *engine);
 uint64        Engine_getFrameNumber(Engine *engine);
+uint64        Engine_getTickNumber( Engine *engine);
 float         Engine_getTickElapsed(Engine *engine);
 void          Engine_setTickRate(   Engine *engine, int tick_rate);
 int           Engine_getTickRate(   Engine *engine);
+void          Engine_setMaxSubsteps(Engine *engine, uint  max_substeps);
+void          Engine_setMaxCatchUpTime(Engine *engine, float seconds);
+void          Engine_setAdaptiveTickRate(Engine *engine, int min_tick_rate);
+double        Engine_getDroppedTime(Engine *engine);
+uint64        Engine_getDroppedTicks(Engine *engine);
 float         Engine_getTickLength( Engine *engine);
 double        Engine_getTime(       Engine *engine);
 double        Engine_getPauseTime(  Engine *engine); 
+const EngineStats *Engine_getStats( Engine *engine);
 uint          Engine_getEntityCount(Engine *engine);
 EntityList   *Engine_getEntityList( Engine *engine);
 Head         *Engine_getHeads(      Engine *engine);
+JobSystem    *Engine_getJobSystem(  Engine *engine);
 Renderer     *Engine_getRenderer(   Engine *engine);
 Scene        *Engine_getScene(      Engine *engine);
+void          Engine_setHeadless(   Engine *engine, bool headless);
+void          Engine_setPipelined(  Engine *engine, bool pipelined);
+bool          Engine_isPipelined(   Engine *engine);
+bool          Engine_isHeadless(    Engine *engine);
+void          Engine_setUpdateLODDistances(Engine *engine, const float distances[UPDATE_LOD_LEVELS]);
+void          Engine_setInputCallback(Engine *engine, EngineInputCallback capture, size_t input_size);
+const void   *Engine_getInput(      Engine *engine);
 void          Engine_setVTable(     Engine *engine, EngineVTable *vtable);
 EngineVTable *Engine_getVTable(     Engine *engine);
 
@@ -56,11 +106,15 @@ EngineVTable *Engine_getVTable(     Engine *engine);
 */
 void      Engine_run(               Engine *engine);
 void      Engine_update(            Engine *engine);
+void      Engine_step(              Engine *engine, uint  n_ticks);
+void      Engine_record(            Engine *engine, Replay *replay);
+double    Engine_replay(            Engine *engine, Replay *replay);
 void      Engine_render(            Engine *engine);
 void      Engine_resize(            Engine *engine, uint  width,  uint height);
 void      Engine_pause(             Engine *engine, bool  paused);
 bool      Engine_isPaused(          Engine *engine);
 void      Engine_requestExit(       Engine *engine);
+void      Engine_drawStats(         Engine *engine, int   x,      int  y,  int font_size);
 
 
 #endif /* ENGINE_H */
@@ -9,31 +9,48 @@ typedef void (*EntityCallback)(         Entity *entity);
 typedef void (*EntityCollisionCallback)(Entity *entity, CollisionResult collision);
 typedef void (*EntityTeleportCallback)( Entity *entity, Vector3         from,      Vector3 to);
 typedef void (*EntityUpdateCallback)(   Entity *entity, float           delta);
+typedef void (*EntitySpawnCallback)(    Entity *spawner, Entity        *spawned);
 
 typedef struct
 EntityVTable
 {
     EntityCallback          Setup;       /* Called on initialization of a new Entity */
     EntityCallback          Enter;       /* Called upon Entity entering the scene */
-    EntityUpdateCallback    Update;      /* Called once every tick prior to rendering */
+    EntityUpdateCallback    ParallelUpdate; /* Called before Update, on any thread if the Scene updates in parallel. Write only to this Entity; use Entity_defer*() for the rest */
+    EntityUpdateCallback    Update;      /* Called once every tick prior to rendering, or less often if update_lod is set */
     EntityUpdateCallback    Render;      /* Called once every frame prior to rendering the Entity */
     EntityCollisionCallback OnCollision; /* Called when the Entity collides with something while moving */
     EntityCollisionCallback OnCollided;  /* Called when another Entity collides with this Entity */
-    EntityTeleportCallback  Teleport;    /* Called when the entity is teleported. Useful when camera interpolation is being used. */
+    EntityTeleportCallback  Teleport;    /* Called when the entity is teleported. Interpolation is skipped for the teleport. */
     EntityCallback          Exit;        /* Called upon Entity exiting the scene */
     EntityCallback          Free;        /* Called upon freeing Entity from memory */
+    EntityCallback          Restore;     /* Called after Scene_restore(), to pass held Entity pointers through Scene_relocateEntity() */
 }
 EntityVTable;
 
 
-typedef struct 
-Entity 
+/*
+    EntityArchetype
+        Read-only data shared by every Entity of a kind, referenced by each
+        of them instead of copied into it.
+*/
+typedef struct
+EntityArchetype
 {
-    void           *user_data;
-    EntityVTable   *vtable;
+    const char     *name;
     Renderable     *renderables[  MAX_LOD_LEVELS];
     float           lod_distances[MAX_LOD_LEVELS];
     uint8           lod_count;
+}
+EntityArchetype;
+
+
+typedef struct 
+Entity 
+{
+    void                  *user_data;
+    EntityVTable          *vtable;
+    const EntityArchetype *archetype;
     int
                     current_anim,
                     anim_frame;
@@ -104,8 +121,8 @@ Entity
             CollisionShape 
                 collision_shape:2; /* 0 = None | 1 = AABB | 2 = Cylinder | 3 = Sphere */
             bool
-                _flag_5        :1,
-                _flag_6        :1,
+                update_lod     :1, /* Update less often the further it is from every Head */
+                interpolate    :1, /* Render between the previous and current tick's transforms */
                 _flag_7        :1;
         };
     };
@@ -114,11 +131,18 @@ Entity
 } 
 Entity;
 
+/*
+    Archetype Registry
+*/
+void             EntityArchetype_register(EntityArchetype *archetype);
+EntityArchetype *EntityArchetype_find(    const char      *name);
+
 /*
     Constructor/Destructor
 */
-Entity  *Entity_new(  const Entity *template_entity, Engine *engine, size_t user_data_size);
-void     Entity_free(       Entity *entity);
+Entity  *Entity_new(     const Entity *template_entity, Engine *engine, size_t user_data_size);
+Entity **Entity_newBatch(const Entity *template_entity, uint count, const Vector3 *positions, size_t user_data_size, Scene *scene);
+void     Entity_free(          Entity *entity);
 
 /*
     Setters/Getters
@@ -126,6 +150,10 @@ void     Entity_free(       Entity *entity);
 double       Entity_getAge(          Entity *entity);
 BoundingBox  Entity_getBoundingBox(  Entity *entity);
 Renderable  *Entity_getLODRenderable(Entity *entity,  Vector3 position, Vector3 camera_position);
+Transform    Entity_getRenderTransform(Entity *entity);
+Matrix       Entity_getInstanceTransform(Entity *entity, Vector3 position);
+Vector3      Entity_getRenderBounds(   Entity *entity);
+int          Entity_getRenderAnimation(Entity *entity, int *anim_frame);
 Engine      *Entity_getEngine(       Entity *entity);
 Entity      *Entity_getNext(         Entity *entity);
 Entity      *Entity_getPrev(         Entity *entity);
@@ -139,6 +167,9 @@ bool         Entity_isOnCeiling(     Entity *entity);
     Methods
 */
 void            Entity_addToScene(     Entity *entity, Scene   *scene);
+void            Entity_deferSpawn(     Entity *entity, const Entity *template_entity, size_t user_data_size, Vector3 position, EntitySpawnCallback on_spawn);
+void            Entity_deferFree(      Entity *entity, Entity  *target);
+void            Entity_deferMove(      Entity *entity, Vector3  movement, bool slide);
 void            Entity_removeFromScene(Entity *entity);
 CollisionResult Entity_move(           Entity *entity, Vector3  movement);
 CollisionResult Entity_moveAndSlide(   Entity *entity, Vector3  movement);
@@ -0,0 +1,57 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+
+#include "common.h"
+
+
+/* Words a visibility mask needs for count items */
+#define FRUSTUM_MASK_WORDS( count ) (((count) + 31) / 32)
+
+
+bool
+isSphereInFrustum(
+        Vector3  center,
+        float    radius,
+        Frustum *frustum
+    );
+bool
+isAABBInFrustum(
+        Vector3  center,
+        Vector3  extents,
+        Frustum *frustum,
+        float    dist_sq,
+        float    max_distance
+    );
+
+/*
+	Batch culling
+		Test count items, packed as one array per component, against all six
+		planes of frustum, several at once where SIMD is available. Bit i % 32
+		of visible[i / 32] is set if item i may be visible; visible must hold
+		FRUSTUM_MASK_WORDS(count) words. Define KOLIBRI_NO_SIMD to force the
+		scalar path.
+*/
+void cullSpheresInFrustum(
+        const Frustum *frustum,
+        const float   *x,
+        const float   *y,
+        const float   *z,
+        const float   *radius,
+        uint           count,
+        uint32        *visible
+    );
+void cullAABBsInFrustum(
+        const Frustum *frustum,
+        const float   *x,
+        const float   *y,
+        const float   *z,
+        const float   *extent_x,
+        const float   *extent_y,
+        const float   *extent_z,
+        uint           count,
+        uint32        *visible
+    );
+
+
+#endif /* FRUSTUM_H */
@@ -8,6 +8,7 @@
 #define DEFAULT_RENDERERSETTINGS ((RendererSettings){ \
 		.max_render_distance    = DEFAULT_MAX_RENDER_DISTANCE, \
 		.max_entities_per_frame = DEFAULT_MAX_ENTITIES_PER_FRAME, \
+		.lod_pixel_error        = DEFAULT_LOD_PIXEL_ERROR, \
 		.flags                  = DEFAULT_RENDER_FLAGS \
 	})
 
@@ -33,15 +34,16 @@ HeadVTable;
 typedef struct
 {
 	float max_render_distance;
-	int   max_entities_per_frame;
+	int   max_entities_per_frame; /* The biggest-looking are kept; 0 for no limit */
+	float lod_pixel_error;        /* Screen-space LOD tolerance; 0 to go by distance */
 	union {
 		uint8 flags;
 		struct {
 			bool frustum_culling          :1;
 			bool sort_transparent_entities:1;
 			bool level_of_detail          :1;
-			bool flag_3                   :1; /* 3-4 not yet defined */
-			bool flag_4                   :1;
+			bool sort_opaque_entities     :1; /* By render state, then front to back */
+			bool occlusion_culling        :1; /* Against the Scene's DrawOccluders */
 			bool draw_entity_origin       :1;
 			bool draw_bounding_boxes      :1;
 			bool show_lod_levels          :1;
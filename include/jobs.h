@@ -0,0 +1,43 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+
+#include "common.h"
+
+
+/*
+	JobHandle
+		Refers to a submitted job. Once the job has finished its slot is
+		recycled, so a stale handle simply reads as complete.
+*/
+typedef struct
+JobHandle
+{
+	uint32 index;
+	uint32 generation;
+}
+JobHandle;
+
+#define JOB_NONE ((JobHandle){UINT32_MAX, 0})
+
+typedef void (*JobFunction)(     void *data);
+typedef void (*JobRangeFunction)(void *data, uint start, uint end);
+
+
+/* Constructor/Destructor */
+JobSystem *JobSystem_new( uint       thread_count);
+void       JobSystem_free(JobSystem *jobs);
+
+/* Setters/Getters */
+uint       JobSystem_getThreadCount(JobSystem *jobs);
+uint       JobSystem_getThreadIndex(JobSystem *jobs);
+
+/* Methods */
+JobHandle  JobSystem_submit(     JobSystem *jobs, JobFunction      function, void *data, const JobHandle *dependencies, uint dependency_count);
+bool       JobSystem_isComplete( JobSystem *jobs, JobHandle        job);
+void       JobSystem_wait(       JobSystem *jobs, JobHandle        job);
+void       JobSystem_waitAll(    JobSystem *jobs, const JobHandle *jobs_to_wait, uint count);
+void       JobSystem_parallelFor(JobSystem *jobs, uint             count,    uint  batch_size, JobRangeFunction function, void *data);
+
+
+#endif /* JOBS_H */
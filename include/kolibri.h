@@ -6,8 +6,15 @@
 #include "dynamicarray.h"
 #include "engine.h"
 #include "entity.h"
+#include "frustum.h"
 #include "head.h"
+#include "jobs.h"
+#include "occlusion.h"
+#include "octree.h"
+#include "profiler.h"
 #include "renderer.h"
+#include "replay.h"
+#include "replication.h"
 #include "scene.h"
 #include "spatialhash.h"
 
@@ -0,0 +1,34 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+
+#include "common.h"
+
+
+/*
+	OcclusionBuffer
+		A small depth buffer rasterised on the CPU. Occluders, big opaque
+		geometry such as walls or terrain, are drawn into it from a camera,
+		then boxes are tested against a hierarchy of its farthest depths to
+		find ones hidden behind them. Depth is stored as one over view
+		distance, so 0 is empty.
+*/
+
+
+/* Constructor/Destructor */
+OcclusionBuffer *OcclusionBuffer_new( uint             width, uint height);
+void             OcclusionBuffer_free(OcclusionBuffer *buffer);
+
+/* Setters/Getters */
+const float *OcclusionBuffer_getDepth(OcclusionBuffer *buffer, uint level, uint *width, uint *height);
+
+/* Methods */
+void OcclusionBuffer_begin(       OcclusionBuffer *buffer, const Camera3D *camera, float aspect);
+void OcclusionBuffer_drawTriangle(OcclusionBuffer *buffer, Vector3 a,      Vector3 b,       Vector3 c);
+void OcclusionBuffer_drawQuad(    OcclusionBuffer *buffer, Vector3 a,      Vector3 b,       Vector3 c, Vector3 d);
+void OcclusionBuffer_drawBox(     OcclusionBuffer *buffer, Vector3 min,    Vector3 max);
+void OcclusionBuffer_finish(      OcclusionBuffer *buffer);
+bool OcclusionBuffer_isBoxOccluded(OcclusionBuffer *buffer, Vector3 center, Vector3 extents);
+
+
+#endif /* OCCLUSION_H */
@@ -0,0 +1,39 @@
+#ifndef OCTREE_H
+#define OCTREE_H
+
+
+#include "common.h"
+
+
+/*
+	LooseOctree
+		Persistent bounding spheres for culling. Each node's cell may hold
+		items reaching up to half its size past its edges, so moving an item
+		only relinks it when its center leaves its cell. Items entirely
+		outside the root are kept in the root and always tested. Repeated
+		queries from one of OCTREE_QUERY_SLOTS viewers reuse each item's
+		last result where they can.
+*/
+typedef struct LooseOctree LooseOctree;
+
+#define OCTREE_NONE UINT32_MAX
+
+
+/* Constructor/Destructor */
+LooseOctree *LooseOctree_new( Vector3      center, float half_size);
+void         LooseOctree_free(LooseOctree *tree);
+
+/* Setters/Getters */
+void        *LooseOctree_getData(  LooseOctree *tree, uint32 item);
+uint         LooseOctree_getCount( LooseOctree *tree);
+
+/* Methods */
+void   LooseOctree_clear(       LooseOctree *tree);
+uint32 LooseOctree_insert(      LooseOctree *tree, void          *data,    Vector3   center, float radius);
+void   LooseOctree_update(      LooseOctree *tree, uint32         item,    Vector3   center, float radius);
+void   LooseOctree_remove(      LooseOctree *tree, uint32         item);
+uint   LooseOctree_queryFrustum(LooseOctree *tree, const Frustum *frustum, uint32  **results);
+uint   LooseOctree_queryFrustumCoherent(LooseOctree *tree, const Frustum *frustum, uint slot, uint32 **results);
+
+
+#endif /* OCTREE_H */
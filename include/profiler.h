@@ -0,0 +1,60 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+
+#include "common.h"
+
+
+/*
+	Profiling zones
+		PROFILE_ZONE("Name") times the rest of the enclosing block. Names must
+		be string literals (or otherwise outlive the Profiler). Unless
+		KOLIBRI_PROFILE is defined, the macros compile to nothing.
+*/
+#define PROFILE_CONCAT_( A, B ) A##B
+#define PROFILE_CONCAT( A, B )  PROFILE_CONCAT_(A, B)
+
+#ifdef KOLIBRI_PROFILE
+	#define PROFILE_ZONE( Name ) \
+		ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__) \
+			__attribute__((cleanup(Profiler_endZone))) = Profiler_beginZone(Name)
+	#define PROFILE_FRAME() Profiler_frame()
+#else
+	#define PROFILE_ZONE( Name )
+	#define PROFILE_FRAME()
+#endif /* KOLIBRI_PROFILE */
+
+
+typedef struct
+ProfileZone
+{
+	const char *name;
+	uint64      start; /* Nanoseconds */
+}
+ProfileZone;
+
+/* Time spent in a zone per frame, over the last PROFILER_HISTORY frames */
+typedef struct
+ProfileStats
+{
+	const char *name;
+	float
+	            min_ms,
+	            avg_ms,
+	            max_ms,
+	            last_ms;
+	uint        last_calls; /* Times the zone was entered last frame */
+}
+ProfileStats;
+
+
+/* Methods */
+ProfileZone Profiler_beginZone( const char   *name);
+void        Profiler_endZone(   ProfileZone  *zone);
+void        Profiler_frame(     void);
+bool        Profiler_getStats(  const char   *name,  ProfileStats *stats);
+uint        Profiler_getAllStats(ProfileStats *stats, uint          max_count);
+bool        Profiler_dumpTrace( const char   *path);
+
+
+#endif /* PROFILER_H */
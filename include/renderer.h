@@ -2,26 +2,13 @@
 #define RENDERER_H
 
 #include "common.h"
+#include "frustum.h"
 
 typedef struct Renderer Renderer;
 
 
-bool
-isSphereInFrustum(
-        Vector3  center, 
-        float    radius, 
-        Frustum *frustum
-    );
-bool
-isAABBInFrustum(
-        Vector3  center,
-        Vector3  extents,
-        Frustum *frustum,
-        float    dist_sq,
-        float    max_distance
-    );
-
 void Renderer_submitEntity(  Renderer *renderer, Entity     *entity);
+void Renderer_submitEntityAt(Renderer *renderer, Entity     *entity,     Vector3 pos);
 void Renderer_submitGeometry(Renderer *renderer, Renderable *renderable, Vector3 pos, Vector3 bounds);
 
 
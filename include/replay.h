@@ -0,0 +1,34 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+
+#include "common.h"
+
+
+/*
+	Replay
+		A recorded session: the RNG seed, tick rate and Engine time it
+		started with, and a fixed-size input snapshot for every tick. Record
+		one with Engine_record() and play it back with Engine_replay(). Files
+		are written in the recording machine's byte order.
+*/
+
+
+/* Constructor/Destructor */
+Replay     *Replay_new( size_t  input_size, uint32      seed);
+Replay     *Replay_load(const char *path);
+void        Replay_free(Replay *replay);
+
+/* Setters/Getters */
+uint32      Replay_getSeed(      Replay *replay);
+int         Replay_getTickRate(  Replay *replay);
+double      Replay_getStartTime( Replay *replay);
+size_t      Replay_getInputSize( Replay *replay);
+uint64      Replay_getTickCount( Replay *replay);
+const void *Replay_getInput(     Replay *replay, uint64      tick);
+
+/* Methods */
+bool        Replay_save(         Replay *replay, const char *path);
+
+
+#endif /* REPLAY_H */
@@ -0,0 +1,56 @@
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+
+#include "common.h"
+
+
+/*
+	WorldState
+		The quantised position, orientation and flags of every Entity in a
+		Scene as of one tick. A server captures one per tick and writes each
+		client a bit-packed delta against the last state that client
+		acknowledged; the client reads it against its own copy of that state
+		and applies the result to its Scene through a Replica. Sending the
+		bytes is left to the game.
+*/
+typedef struct WorldState WorldState;
+
+/*
+	Replica
+		Keeps a client Scene's Entities in step with received WorldStates,
+		creating them through spawn the first time they appear and freeing
+		them once they're gone.
+*/
+typedef struct Replica Replica;
+
+typedef Entity *(*ReplicaSpawnCallback)(Scene *scene, uint64 network_ID);
+
+
+/* Constructor/Destructor */
+WorldState *WorldState_new( void);
+void        WorldState_free(WorldState *state);
+
+/* Setters/Getters */
+uint64      WorldState_getTick(       WorldState *state);
+uint        WorldState_getEntityCount(WorldState *state);
+
+/* Methods */
+void        WorldState_capture(   WorldState *state,       Scene            *scene);
+void        WorldState_copy(      WorldState *state,       const WorldState *source);
+size_t      WorldState_writeDelta(const WorldState *state, const WorldState *baseline, uint8 *buffer, size_t capacity);
+bool        WorldState_readDelta( WorldState *state,       const WorldState *baseline, const uint8 *buffer, size_t size);
+
+
+/* Constructor/Destructor */
+Replica    *Replica_new( Scene   *scene, ReplicaSpawnCallback spawn);
+void        Replica_free(Replica *replica);
+
+/* Setters/Getters */
+Entity     *Replica_getEntity(Replica *replica, uint64            network_ID);
+
+/* Methods */
+void        Replica_apply(    Replica *replica, const WorldState *state);
+
+
+#endif /* REPLICATION_H */
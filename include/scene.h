@@ -5,7 +5,8 @@
 #include "common.h"
 
 
-typedef struct Scene Scene;
+typedef struct Scene         Scene;
+typedef struct SceneSnapshot SceneSnapshot;
 
 
 typedef void            (*SceneCallback)(         Scene *scene);
@@ -15,6 +16,8 @@ typedef void            (*SceneEntityCallback)(   Scene *scene, Entity  *entity)
 typedef CollisionResult (*SceneCollisionCallback)(Scene *scene, Entity  *entity, Vector3 to);
 typedef CollisionResult (*SceneRaycastCallback)(  Scene *scene, Vector3  from,   Vector3 to);
 typedef void            (*SceneRenderCallback)(   Scene *scene, Head    *head);
+typedef void            (*SceneSubmitCallback)(   Scene *scene, Renderer *renderer);
+typedef void            (*SceneOccluderCallback)( Scene *scene, Head    *head,   OcclusionBuffer *buffer);
 
 
 typedef struct
@@ -30,6 +33,8 @@ SceneVTable
     SceneRaycastCallback   Raycast;        /* Called Every time a raycast is performed in order to check if has collided with the scene */
     SceneRenderCallback    PreRender;      /* Called called optionally by a Head during its PreRender callback */
     SceneRenderCallback    Render;         /* Called once every frame in order to render the scene */
+    SceneSubmitCallback    Submit;         /* Called once every frame, before any Head renders, to submit what all of them might draw */
+    SceneOccluderCallback  DrawOccluders;  /* Called every frame for each Head occlusion culling, possibly on another thread, to draw big opaque geometry */
     SceneCallback          Exit;           /* Called upon Scene exiting the engine */
     SceneCallback          Free;           /* Called upon freeing the Scene from memory */
 }
@@ -43,8 +48,11 @@ void            Scene_free(Scene      *scene);
 Engine         *Scene_getEngine(      Scene *scene);
 uint            Scene_getEntityCount( Scene *scene);
 Entity        **Scene_getEntities(    Scene *scene);
+Entity        **Scene_getRenderEntities(Scene *scene);
+uint            Scene_getRenderEntityCount(Scene *scene);
 void           *Scene_getData(        Scene *scene);
 void           *Scene_getInfo(        Scene *scene);
+void            Scene_setParallelUpdate(Scene *scene, bool parallel);
 
 /* Public Methods */
 void            Scene_enter(          Scene *scene);
@@ -56,9 +64,20 @@ CollisionResult Scene_checkContinuous(Scene *scene, Entity  *entity, Vector3 mov
 CollisionResult Scene_raycast(        Scene *scene, Vector3  from,   Vector3 to, Entity *ignore);
 void            Scene_preRender(      Scene *scene, Head    *head);
 void            Scene_render(         Scene *scene, Head    *head);
+void            Scene_submit(         Scene *scene, Renderer *renderer);
+bool            Scene_drawOccluders(  Scene *scene, Head    *head,   OcclusionBuffer *buffer);
 void            Scene_exit(           Scene *scene);
 
 Entity        **Scene_queryRegion(    Scene *scene, BoundingBox  bbox);
+Entity         *Scene_findEntity(     Scene *scene, uint64   unique_ID);
+Entity         *Scene_relocateEntity( Scene *scene, const Entity *entity);
+
+/* Snapshots */
+SceneSnapshot  *SceneSnapshot_new(    void);
+void            SceneSnapshot_free(   SceneSnapshot *snapshot);
+size_t          SceneSnapshot_getSize(SceneSnapshot *snapshot);
+void            Scene_snapshot(       Scene *scene, SceneSnapshot *snapshot, const SceneSnapshot *base);
+void            Scene_restore(        Scene *scene, const SceneSnapshot *snapshot);
 
 
 #endif /* SCENE_H */
@@ -17,6 +17,7 @@ void         SpatialHash_free(SpatialHash *hash);
 void   SpatialHash_clear(      SpatialHash *hash);
 void   SpatialHash_insert(     SpatialHash *hash, void        *data,   Vector3   center,        Vector3  bounds);
 void **SpatialHash_queryRegion(SpatialHash *hash, BoundingBox  region);
+void   SpatialHash_getChainStats(SpatialHash *hash, uint *entry_count, uint *used_cells, uint *max_chain);
 
 
 #endif /* SPATIAL_HASH_H */
@@ -4,6 +4,8 @@
 
 #include "_entity_.h"
 #include "_head_.h"
+#include "_jobs_.h"
+#include "_replay_.h"
 #include "_scene_.h"
 #include "_renderer_.h"
 
@@ -11,6 +13,11 @@
 #include "engine.h"
 
 
+/* Safe to use from any thread */
+#define ENGINE_STAT_ADD( Engine_, Field, Amount ) \
+	__atomic_fetch_add(&Engine__getStats(Engine_)->Field, (Amount), __ATOMIC_RELAXED)
+
+
 Head           *Engine__getHeads(         Engine *engine);
 void            Engine__insertHead(       Engine *engine, Head           *head);
 void            Engine__removeHead(       Engine *engine, Head           *head);
@@ -18,6 +25,8 @@ Scene          *Engine__getScene(         Engine *engine);
 void            Engine__insertScene(      Engine *engine, Scene          *scene);
 void            Engine__removeScene(      Engine *engine, Scene          *scene);
 Renderer       *Engine__getRenderer(      Engine *engine);
+uint8           Engine__getUpdateBucket(  Engine *engine, Vector3         position);
+EngineStats    *Engine__getStats(         Engine *engine);
 
 
 #endif /* ENGINE_PRIVATE_H */
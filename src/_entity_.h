@@ -10,6 +10,17 @@
 #define ENTITY_TO_NODE(e) (((EntityNode*)((char*)(e) - offsetof(EntityNode, base))))
 #define NODE_TO_ENTITY(p) (&((p)->base))
 
+#define ENTITY_NO_SNAPSHOT UINT32_MAX
+
+
+/* Header of a block of EntityNodes allocated together by Entity_newBatch() */
+typedef struct
+EntityBatch
+{
+    uint refs; /* Nodes in the block not yet freed */
+}
+EntityBatch;
+
 
 typedef struct
 EntityNode
@@ -18,13 +29,16 @@ EntityNode
 		*prev,
 		*next;
 
-    Engine *engine;
-    Scene  *scene;
+    Engine      *engine;
+    Scene       *scene;
+    EntityBatch *batch; /* NULL unless allocated by Entity_newBatch() */
 	uint64  unique_ID;
     double  creation_time;
     size_t  size;
-	int     current_lod;
-    float   last_lod_distance; /* Cache to avoid recalculating every frame */
+    int8    current_lod[MAX_NUM_HEADS]; /* Last LOD chosen per Head, -1 if none yet, lod_count if out of range */
+    float   update_delta;      /* Time accumulated since the last Update, for update_lod */
+    uint32  snapshot_index;    /* Into the Scene's previous tick transforms, for interpolate */
+    uint32  view_index[2];     /* Into each of the Scene's views, for pipelined rendering */
     union {
         uint8 flags;
         struct {
@@ -46,12 +60,41 @@ EntityNode
 }
 EntityNode;
 
+/* An Entity as of the end of a tick, for the pipelined renderer to read */
+typedef struct
+EntityRenderState
+{
+    Transform
+        prev_transform,
+        transform;
+    const EntityArchetype *archetype;
+    Vector3
+        bounds,
+        renderable_offset;
+    float visibility_radius;
+    int
+        current_anim,
+        anim_frame;
+    bool
+        visible,
+        interpolate;
+}
+EntityRenderState;
+
+
 /* Destructor */
 void EntityNode__free(     EntityNode *entity_node);
 void EntityNode__freeAll(  EntityNode *entity_node);
 
 
+/* Setters/Getters */
+uint64            Entity__getNextID(void);
+void              Entity__setNextID(uint64 unique_ID);
+EntityRenderState Entity__getRenderState(Entity *entity);
+
+
 /* Methods */
+int  Entity__selectLOD(    Entity     *entity,      const EntityArchetype *archetype, uint8 head_index, float dist_sq);
 void EntityNode__insert(   EntityNode *self,        EntityNode *to);
 void EntityNode__remove(   EntityNode *self);
 void EntityNode__updateAll(EntityNode *entity_node, float delta);
@@ -25,6 +25,7 @@ Head
     Frustum                   frustum;
     Engine                   *engine;
     void                     *user_data;
+    uint8                     index; /* Position in the Engine's Heads, for per-Head caches */
 
     struct Head
 		*prev,
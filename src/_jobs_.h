@@ -0,0 +1,59 @@
+#ifndef JOBS_PRIVATE_H
+#define JOBS_PRIVATE_H
+
+
+#include "jobs.h"
+
+
+#ifndef KOLIBRI_NO_THREADS
+	#include <pthread.h>
+	#include <stdatomic.h>
+
+
+typedef struct
+Job
+{
+	JobFunction      function;
+	void            *data;
+	_Atomic uint32   generation; /* Bumped on completion, invalidating handles */
+	_Atomic uint     pending;    /* Unfinished dependencies, plus one until submitted */
+	uint             dependent_count;
+	uint32           dependents[JOB_MAX_DEPENDENTS];
+	uint32           next_free;
+}
+Job;
+
+/* Ready jobs pushed by one thread; it pops the bottom, others steal the top */
+typedef struct
+JobQueue
+{
+	pthread_mutex_t   lock;
+	uint32           *indices;
+	uint              top,
+	                  bottom;
+	struct JobSystem *owner;
+}
+JobQueue;
+#endif /* !KOLIBRI_NO_THREADS */
+
+
+typedef struct
+JobSystem
+{
+	uint             thread_count; /* Including the thread which created it */
+#ifndef KOLIBRI_NO_THREADS
+	Job             *pool;
+	JobQueue        *queues;       /* One per thread, the creating thread's first */
+	pthread_t       *threads;
+	uint32           free_head;
+	pthread_mutex_t  graph_lock;   /* Guards the free list and dependency edges */
+	pthread_mutex_t  sleep_lock;
+	pthread_cond_t   work_available;
+	_Atomic uint     queued;
+	_Atomic bool     shutdown;
+#endif /* !KOLIBRI_NO_THREADS */
+}
+JobSystem;
+
+
+#endif /* JOBS_PRIVATE_H */
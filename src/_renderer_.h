@@ -1,5 +1,5 @@
-#ifndef RENDERER_H
-#define RENDERER_H
+#ifndef RENDERER_PRIVATE_H
+#define RENDERER_PRIVATE_H
 
 
 #include "engine.h"
@@ -13,9 +13,10 @@ Renderer *Renderer__new( Engine   *engine);
 void      Renderer__free(Renderer *renderer);
 
 /* Protected Methods */
-//RenderableWrapper **Renderer__queryFrustum(           Renderer *renderer,  Head       *head,       float    max_distance, int     *visible_count);
-void Renderer__render(         Renderer *renderer,  Head       *head);
+void Renderer__submit(Renderer *renderer);
+void Renderer__cull(  Renderer *renderer, Head **heads, uint head_count);
+void Renderer__render(Renderer *renderer, Head  *head);
 
 
-#endif /* RENDERER_H */
+#endif /* RENDERER_PRIVATE_H */
 
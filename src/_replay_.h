@@ -0,0 +1,24 @@
+#ifndef REPLAY_PRIVATE_H
+#define REPLAY_PRIVATE_H
+
+
+#include "replay.h"
+
+
+typedef struct
+Replay
+{
+	uint32  seed;
+	int     tick_rate;
+	double  start_time; /* Engine time of the first tick's start */
+	size_t  input_size;
+	uint8  *inputs;     /* DynamicArray of input_size byte snapshots, one per tick */
+}
+Replay;
+
+
+void Replay__begin( Replay *replay, int         tick_rate, double start_time);
+void Replay__append(Replay *replay, const void *input);
+
+
+#endif /* REPLAY_PRIVATE_H */
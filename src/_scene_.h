@@ -7,6 +7,77 @@
 #include "scene.h"
 
 
+typedef enum
+{
+    DEFERRED_SPAWN,
+    DEFERRED_FREE,
+    DEFERRED_MOVE,
+    DEFERRED_MOVE_AND_SLIDE,
+}
+DeferredCommandType;
+
+/* Issued by Entity_defer*() during the ParallelUpdate phase, run after it */
+typedef struct
+DeferredCommand
+{
+    DeferredCommandType type;
+    uint32              sequence;  /* Order issued within its thread's buffer */
+    uint64              issuer_ID;
+    Entity             *issuer;
+    union {
+        Entity *target;
+        struct {
+            const Entity        *template_entity;
+            size_t               user_data_size;
+            EntitySpawnCallback  on_spawn;
+        };
+    };
+    Vector3             vector;
+}
+DeferredCommand;
+
+
+typedef struct
+SceneView
+{
+    Entity            **entities;
+    EntityRenderState  *states;       /* Parallel to entities */
+    float               tick_elapsed;
+}
+SceneView;
+
+
+/* Where an Entity's record is in a snapshot's data */
+typedef struct
+SnapshotEntry
+{
+    uint64        unique_ID;
+    size_t        offset;    /* SNAPSHOT_UNCHANGED in a delta if the same as in its base */
+    const Entity *address;   /* When captured, for Scene_relocateEntity() */
+}
+SnapshotEntry;
+
+/* Where an Entity captured at one address was restored to */
+typedef struct
+EntityRelocation
+{
+    const Entity *from;
+    Entity       *to;
+}
+EntityRelocation;
+
+typedef struct
+SceneSnapshot
+{
+    const struct SceneSnapshot *base; /* NULL unless a delta */
+    uint64                      next_ID;
+    SnapshotEntry              *entries; /* In entity_list order */
+    SnapshotEntry              *sorted;  /* The same by unique_ID, for lookups */
+    uint8                      *data;    /* Records back to back */
+}
+SceneSnapshot;
+
+
 typedef struct 
 Scene
 {
@@ -16,6 +87,21 @@ Scene
     
     Engine          *engine;
 	Entity         **entity_list;
+	Entity         **update_list;     /* Entities due an update this tick */
+	Transform       *prev_transforms; /* Transforms of interpolated entities at the start of the tick */
+	DeferredCommand **command_buffers; /* One per JobSystem thread */
+	DeferredCommand *commands;        /* Every buffer merged, sorted by issuer */
+	uint             command_buffer_count;
+	SceneView        views[2];        /* Double-buffered for pipelined rendering */
+	EntityNode     **pending_frees;   /* Deleted while the front view may still show them */
+	Entity         **id_table;        /* Open addressing by unique_ID, for Scene_findEntity() */
+	uint32           id_capacity,     /* A power of two, or 0 before the first Entity */
+	                 id_count;
+	EntityRelocation *relocations;    /* From the last Scene_restore(), sorted by from */
+	uint8            front_view;
+	/* Kept out of the flags, which the simulation writes while rendering reads these */
+	bool             view_ready;      /* The back view was published since the last swap */
+	bool             has_view;        /* The front view holds something to render */
 	CollisionScene  *collision_scene;
     SceneVTable     *vtable;
     void            *info;
@@ -24,9 +110,9 @@ Scene
         uint8 flags;
         struct {
             bool dirty_EntityList:1;
-			bool flag_1          :1; /* 1-7 not yet defined */
-			bool flag_2          :1;
-            bool flag_3          :1; 
+			bool parallel_update :1; /* Run ParallelUpdate callbacks across the JobSystem */
+			bool deferring       :1; /* In the ParallelUpdate phase, Entity_defer*() is buffered */
+            bool flag_3          :1; /* 3-7 not yet defined */
 			bool flag_4          :1;
 			bool flag_5          :1;
 			bool flag_6          :1;
@@ -42,6 +128,12 @@ Scene;
 void        Scene__freeAll(     Scene *scene);
 void        Scene__render(      Scene *scene, float       delta);
 void        Scene__update(      Scene *scene, float       delta);
+void        Scene__defer(       Scene *scene, DeferredCommand *command);
+void        Scene__publishView( Scene *scene, float       tick_elapsed);
+void        Scene__swapView(    Scene *scene);
+void        Scene__clearView(   Scene *scene);
+void        Scene__indexEntity( Scene *scene, Entity     *entity);
+void        Scene__unindexEntity(Scene *scene, Entity    *entity);
 
 
 #endif /* SCENE_PRIVATE_H */
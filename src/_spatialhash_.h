@@ -18,6 +18,10 @@ SpatialHash
     int           hash_size; /* Number of hash buckets */
     float         cell_size; /* Size of each cell */
 	SpatialEntry *cells[SPATIAL_HASH_SIZE]; 
+	uint          chain_lengths[SPATIAL_HASH_SIZE];
+	uint          entry_count, /* Kept up to date by insert/clear, for the stats */
+	              used_cells,
+	              max_chain;
 }
 SpatialHash;
 
@@ -11,6 +11,7 @@
 #include "_spatialhash_.h"
 #include "common.h"
 #include "dynamicarray.h"
+#include "profiler.h"
 #define RAY2D_COLLISION_IMPLEMENTATION
 #include "../examples/ray_collision_2d.h"
 
@@ -93,6 +94,7 @@ CollisionScene__queryRegion(
 			scene->spatial_hash, 
 			bbox
 		);
+	ENGINE_STAT_ADD(scene->engine, broadphase_queries, 1);
 	
 	return candidates;
 }
@@ -371,11 +373,13 @@ CollisionScene__checkCollision(
 	);
 
 	/* Check AABB collision with each candidate */
+	uint pairs_tested = 0;
 	for (int i = 0; i < DynamicArray_length(candidates); i++) {
 		Entity *other = candidates[i];
 		if (other == entity) continue; /* Skip self */
 		if (!other->collision_shape) continue;
 
+		pairs_tested++;
 		CollisionResult test_result = Collision_checkDiscreet(
 				&temp_entity, 
 				other
@@ -385,6 +389,8 @@ CollisionScene__checkCollision(
 			break; /* Return first collision found */
 		}
 	}
+	ENGINE_STAT_ADD(scene->engine, pairs_tested,     pairs_tested);
+	ENGINE_STAT_ADD(scene->engine, narrowphase_hits, result.hit);
 
 	DynamicArray_free(candidates);
 	return result;
@@ -813,9 +819,11 @@ CollisionScene__moveEntity(
 			bounds
 		);
     
+    uint pairs_tested = 0;
     for (int i = 0; i < DynamicArray_length(candidates); i++) {
         Entity *other = candidates[i];
         if (other == entity || !other->collision_shape) continue;
+        pairs_tested++;
 
         /* Check direction of movement relative to this object */
         Vector3 to_other = Vector3Subtract(other->position, entity->position);
@@ -850,6 +858,8 @@ CollisionScene__moveEntity(
             /* If not solid or no overlap at final position, allow the movement */
         }
     }
+	ENGINE_STAT_ADD(scene->engine, pairs_tested,     pairs_tested);
+	ENGINE_STAT_ADD(scene->engine, narrowphase_hits, result.hit);
 	
 	DynamicArray_free(candidates);
     return result;
@@ -1095,6 +1105,7 @@ CollisionScene__raycast(CollisionScene *scene, K_Ray ray, Entity *ignore)
 			bbox
 		);
 	
+	uint pairs_tested = 0;
 	for (int i = 0; i < DynamicArray_length(candidates); i++) {
 		Entity *entity = candidates[i];
 
@@ -1116,11 +1127,15 @@ CollisionScene__raycast(CollisionScene *scene, K_Ray ray, Entity *ignore)
 			result = Collision_checkRaySphere(  ray, entity);
 			break;
 		}
+		pairs_tested++;
 		
 		if (result.hit && result.distance < closest_result.distance) {
 			closest_result = result;
 		}
 	}
+	ENGINE_STAT_ADD(scene->engine, raycasts,         1);
+	ENGINE_STAT_ADD(scene->engine, pairs_tested,     pairs_tested);
+	ENGINE_STAT_ADD(scene->engine, narrowphase_hits, closest_result.hit);
 	
 	DynamicArray_free(candidates);
 	return closest_result;
@@ -1130,6 +1145,7 @@ CollisionScene__raycast(CollisionScene *scene, K_Ray ray, Entity *ignore)
 void
 CollisionScene__update(CollisionScene *self)
 {
+	PROFILE_ZONE("CollisionScene__update");
 	SpatialHash_clear(self->spatial_hash);
 
 	Entity **entities = Scene_getEntities(self->scene);
@@ -1141,4 +1157,12 @@ CollisionScene__update(CollisionScene *self)
 		if (!(entity->active && entity->collision_shape)) continue;
 		CollisionScene__insertEntity(self, entity);
 	}
+	
+	EngineStats *stats = Engine__getStats(self->engine);
+	SpatialHash_getChainStats(
+			self->spatial_hash,
+			&stats->broadphase_entries,
+			&stats->broadphase_cells,
+			&stats->broadphase_max_chain
+		);
 }
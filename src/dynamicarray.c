@@ -18,6 +18,12 @@ typedef struct
 DynamicArrayHeader;
 
 
+/* Every malloc/realloc made so far, for allocation statistics */
+static size_t Allocation_count = 0;
+
+#define COUNT_ALLOCATION() __atomic_fetch_add(&Allocation_count, 1, __ATOMIC_RELAXED)
+
+
 /*******************************
     Constructor / Destructor
 *******************************/
@@ -25,6 +31,7 @@ void *
 DynamicArray_new( size_t datum_size, size_t capacity )
 {
 	DynamicArrayHeader *array   = malloc(sizeof(DynamicArrayHeader) + (datum_size * capacity));
+	COUNT_ALLOCATION();
 	if (!array) {
 		ERR_OUT("Failed to allocate DynamicArray.");
 		return NULL;
@@ -54,6 +61,7 @@ DynamicArray_grow(void **self)
     size_t new_size = sizeof(DynamicArrayHeader) + (new_capacity * old_header->datum_size);
     
     DynamicArrayHeader *new_header = realloc(old_header, new_size);
+    COUNT_ALLOCATION();
     if (!new_header) {
         return;
     }
@@ -75,6 +83,7 @@ DynamicArray_shrink(void *self)
 				* header->datum_size
 			) + sizeof(DynamicArrayHeader)
 		);
+	COUNT_ALLOCATION();
 	if (!new_arr) {
 		return;
 	}
@@ -115,6 +124,13 @@ DynamicArray_clear(void *self)
 	GET_HEADER(self)->length = 0;
 } /* DynamicArray_clear */
 
+void
+DynamicArray_truncate(void *self, size_t length)
+{
+	DynamicArrayHeader *header = GET_HEADER(self);
+	if (length < header->length) header->length = length;
+} /* DynamicArray_truncate */
+
 void
 DynamicArray_concat(void **self, void *array)
 {
@@ -128,8 +144,9 @@ DynamicArray_delete(void *self, size_t index, size_t size)
 {
 	DynamicArrayHeader *header = GET_HEADER(self);
 	
-	int rest = header->length - index;
-	memcpy(INDEX(header, index), INDEX(header, index + size), rest * header->datum_size);
+	/* Only what follows the deleted run moves, and it may overlap it */
+	size_t rest = header->length - index - size;
+	memmove(INDEX(header, index), INDEX(header, index + size), rest * header->datum_size);
 	header->length -= size;
 } /* DynamicArray_delete */
 
@@ -172,3 +189,31 @@ DynamicArray_replace(void **self, size_t index, void *data, size_t size)
 	memcpy(INDEX(header, index), data, size * header->datum_size);
 	header->length = (header->length < amount) ? amount : header->length;
 } /* DynamicArray_replace */
+
+
+void
+DynamicArray_reserve(void **self, size_t capacity)
+{
+	DynamicArrayHeader *header = GET_HEADER(*self);
+	if (capacity <= header->capacity) return;
+	
+	DynamicArrayHeader *new_header = realloc(
+			header,
+			sizeof(DynamicArrayHeader) + (capacity * header->datum_size)
+		);
+	COUNT_ALLOCATION();
+	if (!new_header) {
+		ERR_OUT("Failed to reserve DynamicArray capacity.");
+		return;
+	}
+	
+	new_header->capacity = capacity;
+	*self = (void*)new_header->data;
+} /* DynamicArray_reserve */
+
+
+size_t
+DynamicArray_getAllocationCount(void)
+{
+	return __atomic_load_n(&Allocation_count, __ATOMIC_RELAXED);
+} /* DynamicArray_getAllocationCount */
\ No newline at end of file
@@ -1,6 +1,11 @@
+#include <errno.h>
 #include <raylib.h>
+#include <string.h>
+#include <time.h>
 #include "_engine_.h"
 #include "_renderer_.h"
+#include "dynamicarray.h"
+#include "profiler.h"
 
 
 #ifdef __PSP__
@@ -28,8 +33,54 @@ GetTime_PSP(void)
 #endif
 
 
+/* Monotonic clock which, unlike GetTime(), doesn't need a window */
+static double
+getHeadlessTime(void)
+{
+	struct timespec now;
+#if defined(__unix__) || defined(__APPLE__)
+	clock_gettime(CLOCK_MONOTONIC, &now);
+#else
+	timespec_get(&now, TIME_UTC);
+#endif
+	return (double)now.tv_sec + (double)now.tv_nsec / 1000000000.0;
+}
+
+/* Sleep most of the way to a getHeadlessTime() time, then spin to it */
+static void
+sleepUntil(double target_time)
+{
+	double sleep_until = target_time - ENGINE_SPIN_MARGIN;
+	
+	if (getHeadlessTime() < sleep_until) {
+		struct timespec wake = {
+				.tv_sec  = (time_t)sleep_until,
+				.tv_nsec = (long)((sleep_until - (time_t)sleep_until) * 1000000000.0)
+			};
+		if (999999999 < wake.tv_nsec) wake.tv_nsec = 999999999; /* Rounding */
+#if defined(__linux__)
+		/* Only a signal is worth retrying for; any other error falls back to spinning */
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR) ;
+#elif defined(__unix__) || defined(__APPLE__)
+		double          remaining = sleep_until - getHeadlessTime();
+		struct timespec duration  = {
+				.tv_sec  = (time_t)remaining,
+				.tv_nsec = (long)((remaining - (time_t)remaining) * 1000000000.0)
+			};
+		if (999999999 < duration.tv_nsec) duration.tv_nsec = 999999999;
+		nanosleep(&duration, NULL);
+		(void)wake;
+#else
+		(void)wake;
+#endif
+	}
+	while (getHeadlessTime() < target_time) ;
+}
+
+
+/* Heads are a circular list, head_count long, starting at heads */
 #define foreach_Head( head_ptr ) \
-	for (unsigned i = 0; i < self->head_count && ((head_ptr) = &self->heads[i], 1); i++)
+	for (unsigned i = 0; i < self->head_count && ((head_ptr) = i ? (head_ptr)->next : self->heads, 1); i++)
 	
 #ifdef HEAD_USE_RENDER_TEXTURE
 	#define BeginRenderMode( head ) do { \
@@ -42,7 +93,7 @@ GetTime_PSP(void)
 	#define EndRenderMode() EndTextureMode()
 #elif ENGINE_SINGLE_HEAD_ONLY
 	#define foreach_Head( head_ptr ) \
-		for ((head_ptr) = &self->heads[0]; (head_ptr); (head_ptr) = NULL)
+		for ((head_ptr) = self->heads; (head_ptr); (head_ptr) = NULL)
 	#define BeginRenderMode( head )
 	#define EndRenderMode()
 #else /* SCISSOR MODE */
@@ -66,6 +117,18 @@ Engine
 	Head           *heads;
 	Scene          *scene;
 	Renderer       *renderer;
+	JobSystem      *jobs;
+	JobHandle       simulation; /* Ticks running alongside rendering, if pipelined */
+	EngineStats     stats,      /* Being counted this frame */
+	                last_stats;
+	size_t          last_allocation_count;
+	
+	EngineInputCallback capture; /* Fills input at the start of each tick */
+	void           *input;
+	size_t          input_size;
+	Replay         *recording,   /* Appended to every tick */
+	               *replaying;   /* Overrides capture while playing back */
+	uint64          replay_tick;
 
 	EntityNode     *entities;
 	
@@ -86,24 +149,35 @@ Engine
 					delta, 
 					tick_length,
 					tick_elapsed;
+	float           update_lod_distances[UPDATE_LOD_LEVELS]; /* Squared */
+	float           max_catch_up_time;
+	double          dropped_time;  /* Simulation time skipped to avoid falling behind */
+	uint64          dropped_ticks;
+	double          tick_time;     /* End of the tick being run, for Engine_getTime() */
+	bool            ticking;       /* Not a flag: written by whichever thread ticks */
 
 	uint       
 					entity_count,
 		            head_count,
 		            scene_count,
-		            target_fps;
+		            target_fps,
+		            max_substeps;
 	
-	int             tick_rate;
+	int             
+					tick_rate,
+					base_tick_rate, /* As last set by the user, for adaptive_tick_rate */
+					min_tick_rate,
+					load_streak;    /* Overloaded frames in a row if positive, else calm ones */
 	
 	union {
 		uint8 flags;
 		struct {
 			bool paused      :1;
 			bool request_exit:1;
-			bool flag_2      :1; /* 2-7 not yet defined */
-			bool flag_3      :1; 
-			bool flag_4      :1;
-			bool flag_5      :1;
+			bool headless    :1; /* No window or GL context; keeps its own clock */
+			bool adaptive_tick_rate:1; /* Lower the tick rate under sustained overload */
+			bool pipelined   :1; /* Tick on a worker while drawing the last ticks' Scene view */
+			bool flag_5      :1; /* 5-7 not yet defined */
 			bool flag_6      :1;
 			bool flag_7      :1;
 		};
@@ -112,6 +186,134 @@ Engine
 Engine;
 
 
+static void runPipelinedFrame(Engine *engine);
+static void finishFrameStats( Engine *engine);
+
+
+/* Set on the main thread while it draws alongside pipelined ticks */
+static _Thread_local bool drawing_alongside_ticks = false;
+
+
+static inline double
+getTime(Engine *self)
+{
+	return self->headless ? getHeadlessTime() : GetTime();
+}
+
+
+/* Close the frame's counters; nothing else may be counting at the time */
+static void
+finishFrameStats(Engine *self)
+{
+	size_t allocations = DynamicArray_getAllocationCount();
+	
+	self->stats.frame        = self->frame_num;
+	self->stats.entity_count = self->scene ? Scene_getEntityCount(self->scene) : 0;
+	self->stats.allocations += allocations - self->last_allocation_count;
+	
+	self->last_allocation_count = allocations;
+	self->last_stats            = self->stats;
+	self->stats                 = (EngineStats){0};
+}
+
+
+/* Seed both rand() and raylib's GetRandomValue() */
+static void
+seedRandom(uint32 seed)
+{
+	srand(seed);
+	SetRandomSeed(seed);
+}
+
+/* This tick's input: played back from a Replay, or captured and maybe recorded */
+static void
+readInput(Engine *self)
+{
+	if (self->replaying) {
+		const void *input = Replay_getInput(self->replaying, self->replay_tick++);
+		if (input) memcpy(self->input, input, self->input_size);
+		return;
+	}
+	if (!self->capture) return;
+	
+	self->capture(self, self->input);
+	if (self->recording) Replay__append(self->recording, self->input);
+}
+
+
+/* Run a single tick of the simulation: the Engine's Tick, then the Scene */
+static void
+tick(Engine *self)
+{
+	PROFILE_ZONE("Tick");
+	const EngineVTable *vtable = self->vtable;
+	
+	ENGINE_STAT_ADD(self, ticks, 1);
+	readInput(self);
+	
+	/* Whatever the frame's clock says, so a replay sees the same times */
+	self->tick_time = self->last_tick_time + self->tick_length;
+	self->ticking   = true;
+	
+	if (vtable && vtable->Tick) vtable->Tick(self, self->tick_length);
+	
+	Scene_update(self->scene, self->tick_length);
+	
+	self->ticking         = false;
+	self->last_tick_time += self->tick_length;
+	self->tick_num++;
+}
+
+static void
+setTickRate(Engine *self, int tick_rate)
+{
+	self->tick_rate   = tick_rate;
+	if (tick_rate <= 0) return;
+	self->tick_length = 1.0f / tick_rate;
+}
+
+/* Skip simulation time instead of trying to run it all, keeping the tick phase */
+static void
+dropTime(Engine *self, double seconds)
+{
+	uint64 ticks = (uint64)(seconds / self->tick_length);
+	if (!ticks) return;
+	
+	double dropped = ticks * (double)self->tick_length;
+	ENGINE_STAT_ADD(self, dropped_ticks, ticks);
+	self->last_tick_time += dropped;
+	self->dropped_time   += dropped;
+	self->dropped_ticks  += ticks;
+}
+
+/* Step the tick rate down under sustained overload, and back up once it passes */
+static void
+adaptTickRate(Engine *self, bool overloaded)
+{
+	if (!self->adaptive_tick_rate) return;
+	
+	if (overloaded) self->load_streak = (self->load_streak < 0) ? 1 : self->load_streak + 1;
+	else            self->load_streak = (self->load_streak > 0) ? -1 : self->load_streak - 1;
+	
+	if (
+		ENGINE_OVERLOAD_FRAMES <= self->load_streak 
+		&& self->min_tick_rate < self->tick_rate
+	) {
+		int tick_rate = self->tick_rate * 3 / 4;
+		setTickRate(self, (tick_rate < self->min_tick_rate) ? self->min_tick_rate : tick_rate);
+		self->load_streak = 0;
+	}
+	else if (
+		self->load_streak <= -4 * ENGINE_OVERLOAD_FRAMES 
+		&& self->tick_rate < self->base_tick_rate
+	) {
+		int tick_rate = self->tick_rate * 4 / 3 + 1;
+		setTickRate(self, (self->base_tick_rate < tick_rate) ? self->base_tick_rate : tick_rate);
+		self->load_streak = 0;
+	}
+}
+
+
 /******************
 	CONSTRUCTOR
 ******************/
@@ -124,13 +326,15 @@ Engine_new(EngineVTable *vtable, int tick_rate)
 		ERR_OUT("Failed to allocate memory for Engine.");
 		return NULL;
 	}
-	double current_time = GetTime();
+	double current_time = getHeadlessTime();
 
 	*engine                   = (Engine){0};
 
 	engine->heads             = NULL;
 	engine->scene             = NULL;
 	engine->renderer          = Renderer__new(engine);
+	engine->jobs              = JobSystem_new(ENGINE_JOB_THREADS);
+	engine->simulation        = JOB_NONE;
 	engine->frame_num         = 0;
 	engine->tick_num          = 0;
 	engine->head_count        = 0;
@@ -138,6 +342,10 @@ Engine_new(EngineVTable *vtable, int tick_rate)
 	engine->tick_length       = 1.0f / tick_rate;
 	engine->tick_elapsed      = 1.0f;
 	engine->tick_rate         = tick_rate;
+	engine->base_tick_rate    = tick_rate;
+	engine->min_tick_rate     = tick_rate;
+	engine->max_substeps      = ENGINE_MAX_SUBSTEPS;
+	engine->max_catch_up_time = ENGINE_MAX_CATCH_UP_TIME;
 	engine->last_tick_time    = current_time;
 	engine->current_time      = engine->last_tick_time;
 	engine->start_time        = 0.0f;
@@ -147,6 +355,11 @@ Engine_new(EngineVTable *vtable, int tick_rate)
 	engine->paused            = false;
 	engine->request_exit      = false;
 	
+	for (int i = 0; i < UPDATE_LOD_LEVELS; i++) {
+		float distance = DEFAULT_UPDATE_LOD_DISTANCE * (1 << i);
+		engine->update_lod_distances[i] = distance * distance;
+	}
+	
 	engine->vtable            = vtable;
 
 	if (vtable && vtable->Setup) vtable->Setup(engine);
@@ -162,6 +375,8 @@ Engine_free(Engine *self)
 	Scene__freeAll(self->scene);
 	EntityNode__freeAll(self->entities);
 	Renderer__free(self->renderer);
+	JobSystem_free(self->jobs);
+	free(self->input);
 	free(self);
 }
 
@@ -182,6 +397,12 @@ Engine_getFrameNumber(Engine *self)
 	return self->frame_num;
 }
 
+uint64
+Engine_getTickNumber(Engine *self)
+{
+	return self->tick_num;
+}
+
 float
 Engine_getTickElapsed(Engine *self)
 {
@@ -191,9 +412,9 @@ Engine_getTickElapsed(Engine *self)
 void
 Engine_setTickRate(Engine *self, int tick_rate)
 {
-	self->tick_rate   = tick_rate;
-	if (tick_rate <= 0) return;
-	self->tick_length = 1.0f / tick_rate;
+	self->base_tick_rate = tick_rate;
+	self->load_streak    = 0;
+	setTickRate(self, tick_rate);
 }
 
 int
@@ -202,15 +423,93 @@ Engine_getTickRate(Engine *self)
 	return self->tick_rate;
 }
 
+/* 0 lets a frame run as many ticks as it takes to catch up */
+void
+Engine_setMaxSubsteps(Engine *self, uint max_substeps)
+{
+	self->max_substeps = max_substeps;
+}
+
+/* 0 never drops time, however far behind the simulation falls */
+void
+Engine_setMaxCatchUpTime(Engine *self, float seconds)
+{
+	self->max_catch_up_time = seconds;
+}
+
+/*
+	While frames keep hitting the substep or catch-up limits, lower the tick
+	rate step by step down to min_tick_rate, raising it back to the rate set
+	with Engine_setTickRate() once they stop. A min_tick_rate of 0 turns it
+	off. Note ticks then vary in length, so this isn't for lockstep games.
+*/
+void
+Engine_setAdaptiveTickRate(Engine *self, int min_tick_rate)
+{
+	self->adaptive_tick_rate = (0 < min_tick_rate);
+	self->min_tick_rate      = min_tick_rate;
+	self->load_streak        = 0;
+	
+	if (!self->adaptive_tick_rate && self->tick_rate != self->base_tick_rate)
+		setTickRate(self, self->base_tick_rate);
+}
+
+/*
+	Run each frame's ticks as a job while the main thread draws the ticks
+	run the frame before, from a view of the Scene they left behind. This
+	costs a frame of latency. Tick, Scene Update and entity Update callbacks
+	then run off the main thread, and Scene Render callbacks should get
+	their entities with Scene_getRenderEntities(). Call from the main thread.
+*/
+void
+Engine_setPipelined(Engine *self, bool pipelined)
+{
+	if (self->pipelined == pipelined || !self->jobs) return;
+	
+	JobSystem_wait(self->jobs, self->simulation);
+	self->simulation = JOB_NONE;
+	self->pipelined  = pipelined;
+	
+	if (!self->scene) return;
+	if (!pipelined) {
+		Scene__clearView(self->scene);
+		return;
+	}
+	/* So the first frame has something to draw while the first ticks run */
+	Scene__publishView(self->scene, self->tick_elapsed);
+	Scene__swapView(self->scene);
+}
+
+bool
+Engine_isPipelined(Engine *self)
+{
+	return self->pipelined;
+}
+
+double
+Engine_getDroppedTime(Engine *self)
+{
+	return self->dropped_time;
+}
+
+uint64
+Engine_getDroppedTicks(Engine *self)
+{
+	return self->dropped_ticks;
+}
+
 float
 Engine_getTickLength(Engine *self)
 {
 	return self->tick_length;
 }
 
+/* During a tick, the time at its end, however late it runs; otherwise the frame's */
 double
 Engine_getTime(Engine *self)
 {
+	if (!drawing_alongside_ticks && self->ticking) return self->tick_time;
+	
 	return self->current_time;
 }
 
@@ -226,6 +525,19 @@ Engine_getHeads(Engine *self)
 	return self->heads;
 }
 
+/* Counters from the last finished frame */
+const EngineStats *
+Engine_getStats(Engine *self)
+{
+	return &self->last_stats;
+}
+
+JobSystem *
+Engine_getJobSystem(Engine *self)
+{
+	return self->jobs;
+}
+
 Renderer *
 Engine_getRenderer(Engine *self)
 {
@@ -239,6 +551,64 @@ Engine_getScene(Engine *self)
 }
 
 
+/*
+	A headless Engine never touches the window, and its Engine_run() sleeps
+	between ticks rather than spinning. Set it before Engine_run().
+*/
+void
+Engine_setHeadless(Engine *self, bool headless)
+{
+	self->headless = headless;
+}
+
+bool
+Engine_isHeadless(Engine *self)
+{
+	return self->headless;
+}
+
+
+/*
+	Distances are the upper bound of each update bucket. Entities with
+	update_lod set further than the last one land in the last bucket.
+*/
+void
+Engine_setUpdateLODDistances(Engine *self, const float distances[UPDATE_LOD_LEVELS])
+{
+	for (int i = 0; i < UPDATE_LOD_LEVELS; i++) {
+		self->update_lod_distances[i] = distances[i] * distances[i];
+	}
+}
+
+
+/*
+	capture is called at the start of every tick to fill an input_size
+	snapshot of the player's input, which Tick and Update callbacks should
+	read with Engine_getInput() instead of polling raylib, so the tick can
+	be recorded and replayed.
+*/
+void
+Engine_setInputCallback(Engine *self, EngineInputCallback capture, size_t input_size)
+{
+	void *input = input_size ? calloc(1, input_size) : NULL;
+	if (input_size && !input) {
+		ERR_OUT("Failed to allocate Engine input snapshot.");
+		return;
+	}
+	free(self->input);
+	
+	self->capture    = capture;
+	self->input      = input;
+	self->input_size = input_size;
+}
+
+/* The current tick's input snapshot, or NULL without an input callback */
+const void *
+Engine_getInput(Engine *self)
+{
+	return self->input;
+}
+
 void 
 Engine_setVTable(Engine *self, EngineVTable *vtable)
 {
@@ -258,16 +628,16 @@ Engine_run(Engine *self)
 {
 	const EngineVTable *vtable = self->vtable;
 	self->request_exit    = false;
-	self->start_time      = GetTime();
+	self->start_time      = getTime(self);
 	
 	self->current_time    = 0.0f;
 	self->last_tick_time  = self->tick_length;
 	self->last_frame_time = self->tick_length;
 	
-	SetExitKey(KEY_NULL);
+	if (!self->headless) SetExitKey(KEY_NULL);
 	
 	if (vtable && vtable->Run) vtable->Run(self);
-	if (self->head_count) {
+	if (self->head_count && !self->headless) {
 		while(!self->request_exit) {
 		
 #ifndef __PSP__
@@ -289,6 +659,13 @@ Engine_run(Engine *self)
 			
 			self->screen_size = new_screen_size;
 			
+			if (self->pipelined) {
+				runPipelinedFrame(self);
+				self->frame_num++;
+				PROFILE_FRAME();
+				continue;
+			}
+			
 			Engine_update(self);
 			/* For extrapolation: how far into the next tick are we? */
 			self->tick_elapsed = (
@@ -299,32 +676,50 @@ Engine_run(Engine *self)
 				rlDrawRenderBatchActive(); 
 			EndDrawing();
 			self->frame_num++;
+			finishFrameStats(self);
+			PROFILE_FRAME();
 		}
+		
+		if (self->jobs) JobSystem_wait(self->jobs, self->simulation);
+		self->simulation = JOB_NONE;
 	}
 	else { /* For uses such as game servers */
+		self->headless = true;
+		self->start_time = getTime(self);
+		
 		while(!self->request_exit) {
-			self->request_exit = WindowShouldClose();
-
 			Engine_update(self);
 			/* For extrapolation: how far into the next tick are we? */
 			self->tick_elapsed = (
 					self->current_time - self->last_tick_time
 				) / self->tick_length;
 			self->frame_num++;
+			finishFrameStats(self);
+			PROFILE_FRAME();
+			
+			/* Nothing to do until the next tick is due */
+			double next_tick = self->start_time 
+				+ self->time_spent_paused 
+				+ self->last_tick_time 
+				+ self->tick_length;
+			if (self->paused || self->tick_rate <= 0) next_tick = getTime(self) + self->tick_length;
+			sleepUntil(next_tick);
 		}
 	}
 	if (vtable && vtable->Exit) vtable->Exit(self);
 }
 
 
-void
-Engine_update(Engine *self)
+/* The once-a-frame half of Engine_update(). False if paused or exiting */
+static bool
+updateFrame(Engine *self)
 {
 	//DBG_OUT("Engine updating...");
-	if (self->paused || self->request_exit) return;
+	if (self->paused || self->request_exit) return false;
+	PROFILE_ZONE("Engine frame update");
 	const EngineVTable *vtable = self->vtable;
 	
-	double raw_time = GetTime();
+	double raw_time = getTime(self);
 	self->current_time = raw_time - self->start_time - self->time_spent_paused;
 	float frame_delta = self->current_time - self->last_frame_time;
 	self->last_frame_time = self->current_time;
@@ -334,36 +729,212 @@ Engine_update(Engine *self)
 		vtable->Update(self, self->delta);
 	}
 	
-	Head__updateAll(self->heads, frame_delta);
+	{
+		PROFILE_ZONE("Head__updateAll");
+		Head__updateAll(self->heads, frame_delta);
+	}
 	
+	return true;
+}
+
+/* The ticks half of Engine_update(), running however many are due */
+static void
+runTicks(Engine *self)
+{
 	if (self->tick_rate <= 0) return;
+	PROFILE_ZONE("Engine ticks");
 
+	/* A hitch shouldn't cost more than max_catch_up_time of catching up */
+	double behind     = self->current_time - self->last_tick_time;
+	bool   overloaded = false;
+	
+	/* A recording must tick through every moment, or its replay won't line up */
+	if (!self->recording && 0.0f < self->max_catch_up_time && self->max_catch_up_time < behind) {
+		dropTime(self, behind - self->max_catch_up_time);
+		overloaded = true;
+	}
+	
 	/* Run ticks for elapsed time */
+	uint substeps = 0;
 	while (self->tick_length <= self->current_time - self->last_tick_time) {
-		if (vtable && vtable->Tick) {
-			vtable->Tick(self, self->delta);
+		if (self->max_substeps && self->max_substeps <= substeps) {
+			/* Still behind: drop the rest, or the next frame starts further back */
+			if (!self->recording) dropTime(self, self->current_time - self->last_tick_time);
+			overloaded = true;
+			break;
 		}
-		
-		Scene_update(self->scene, self->tick_length);
-		if (vtable && vtable->Tick) vtable->Tick(self, self->tick_length);
-		
-		self->last_tick_time += self->tick_length;
-		self->tick_num++;
+		tick(self);
+		substeps++;
+	}
+	
+	adaptTickRate(self, overloaded);
+}
+
+static void
+simulate(void *data)
+{
+	Engine *self = data;
+	
+	runTicks(self);
+	
+	if (self->scene) {
+		PROFILE_ZONE("Scene__publishView");
+		Scene__publishView(
+				self->scene, 
+				(self->current_time - self->last_tick_time) / self->tick_length
+			);
+	}
+}
+
+/*
+	Wait for the ticks started last frame, show what they left, then start
+	this frame's ticks and draw while they run.
+*/
+static void
+runPipelinedFrame(Engine *self)
+{
+	Scene *scene = self->scene;
+	
+	{
+		PROFILE_ZONE("Pipeline wait");
+		JobSystem_wait(self->jobs, self->simulation);
+		self->simulation = JOB_NONE;
+	}
+	/* The only point in a pipelined frame where nothing else is counting */
+	finishFrameStats(self);
+	
+	if (scene) {
+		/* A Scene the ticks just switched to has no view of its own yet */
+		if (!scene->has_view && !scene->view_ready) Scene__publishView(scene, self->tick_elapsed);
+		Scene__swapView(scene);
+		self->tick_elapsed = scene->views[scene->front_view].tick_elapsed;
+	}
+	
+	if (updateFrame(self)) {
+		/* Entity Render callbacks run now, while nothing else touches the entities */
+		if (scene) Scene__render(scene, self->delta);
+		self->simulation = JobSystem_submit(self->jobs, simulate, self, NULL, 0);
+	}
+	
+	drawing_alongside_ticks = true;
+	BeginDrawing();
+		Engine_render(self);
+		rlDrawRenderBatchActive(); 
+	EndDrawing();
+	drawing_alongside_ticks = false;
+}
+
+
+void
+Engine_update(Engine *self)
+{
+	if (updateFrame(self)) runTicks(self);
+}
+
+
+/*
+	Run exactly n_ticks ticks, with no regard for the clock, e.g. when
+	embedding the Engine in something else that decides when time passes.
+*/
+void
+Engine_step(Engine *self, uint n_ticks)
+{
+	if (self->paused || self->tick_rate <= 0) return;
+	
+	for (uint i = 0; i < n_ticks && !self->request_exit; i++) {
+		self->current_time = self->last_tick_time + self->tick_length;
+		self->delta        = self->tick_length;
+		tick(self);
 	}
+	self->tick_elapsed = 0.0f;
+	finishFrameStats(self);
+}
+
+
+/*
+	Record every following tick's input into replay, after seeding the RNG
+	with its seed and fixing the tick rate. NULL stops recording. While
+	recording, no time is dropped to catch up and update_lod is ignored,
+	since neither would happen the same way in the replay.
+*/
+void
+Engine_record(Engine *self, Replay *replay)
+{
+	self->recording = NULL;
+	if (!replay) return;
+	
+	if (Replay_getInputSize(replay) != self->input_size) {
+		ERR_OUT("Replay input size differs from the Engine's input callback.");
+		return;
+	}
+	
+	Engine_setAdaptiveTickRate(self, 0);
+	Replay__begin(replay, self->tick_rate, self->last_tick_time);
+	seedRandom(Replay_getSeed(replay));
+	self->recording = replay;
+}
+
+/*
+	Play replay back from the start, headless and as fast as possible, and
+	return the wall-clock seconds it took. Call it on an Engine set up as it
+	was when recording began; only per-tick callbacks run, so frame Update
+	callbacks must not change the simulation.
+*/
+double
+Engine_replay(Engine *self, Replay *replay)
+{
+	if (Replay_getInputSize(replay) != self->input_size) {
+		ERR_OUT("Replay input size differs from the Engine's input callback.");
+		return -1.0;
+	}
+	if (Replay_getTickRate(replay) <= 0) {
+		ERR_OUT("Replay was never recorded.");
+		return -1.0;
+	}
+	if (self->pipelined) Engine_setPipelined(self, false);
+	
+	Engine_setTickRate(self, Replay_getTickRate(replay));
+	Engine_setAdaptiveTickRate(self, 0);
+	seedRandom(Replay_getSeed(replay));
+	self->last_tick_time = Replay_getStartTime(replay);
+	
+	self->recording    = NULL;
+	self->replaying    = replay;
+	self->replay_tick  = 0;
+	self->request_exit = false;
+	
+	double start = getHeadlessTime();
+	
+	/* A tick at a time, so each shows up in Engine_getStats() */
+	uint64 tick_count = Replay_getTickCount(replay);
+	Engine_pause(self, false);
+	while (self->replay_tick < tick_count && !self->request_exit) Engine_step(self, 1);
+	
+	self->replaying = NULL;
+	
+	return getHeadlessTime() - start;
 }
 
 
 void
 Engine_render(Engine *self)
 {
+	PROFILE_ZONE("Engine_render");
 	//EntityNode__renderAll(self->scene->entities, self->delta);
-	Scene__render(self->scene, self->delta);
+	if (!self->pipelined) Scene__render(self->scene, self->delta);
 	const EngineVTable *vtable = self->vtable;
 	ClearBackground(BLACK);
-	/* Loop through Heads */
-	/* Render to Head stage */
+	/* Submit once, then cull for every Head at once */
 	Head *current_head;
+	Head *heads[MAX_NUM_HEADS];
+	uint  head_count = 0;
+	
+	foreach_Head(current_head) heads[head_count++] = current_head;
+	Renderer__submit(self->renderer);
+	Renderer__cull(self->renderer, heads, head_count);
 	
+	/* Loop through Heads */
+	/* Render to Head stage */
 	foreach_Head(current_head) {
 		//current_head = &self->heads[i];
 		BeginRenderMode(current_head);
@@ -403,10 +974,10 @@ Engine_pause(Engine *self, bool Paused)
 		self->paused = Paused;
 		EngineVTable *vtable = self->vtable;
 		if (Paused) {
-			self->last_pause_time = GetTime();
+			self->last_pause_time = getTime(self);
 			if (vtable && vtable->Pause) vtable->Pause(self);
 		} else {
-			self->time_spent_paused += GetTime() - self->last_pause_time;
+			self->time_spent_paused += getTime(self) - self->last_pause_time;
 			if (vtable && vtable->Unpause) vtable->Unpause(self);
 		}
 	}
@@ -426,6 +997,54 @@ Engine_requestExit(Engine *self)
 	self->request_exit = true;
 }
 
+
+/* Overlay of the last frame's counters; call between BeginDrawing/EndDrawing */
+void
+Engine_drawStats(Engine *self, int x, int y, int font_size)
+{
+	const EngineStats *stats = &self->last_stats;
+	
+	/* TextFormat only rotates through a few buffers, so draw each line as it's formatted */
+	DrawText(
+		TextFormat("Frame %llu: %u ticks, %u dropped", (unsigned long long)stats->frame, stats->ticks, stats->dropped_ticks),
+		x, y, font_size, WHITE
+	);
+	DrawText(
+		TextFormat("Entities: %u (%u updated)", stats->entity_count, stats->entities_updated),
+		x, y + font_size, font_size, WHITE
+	);
+	DrawText(
+		TextFormat(
+			"Broadphase: %u entries, %u cells, longest chain %u",
+			stats->broadphase_entries, stats->broadphase_cells, stats->broadphase_max_chain
+		),
+		x, y + 2 * font_size, font_size, WHITE
+	);
+	DrawText(
+		TextFormat(
+			"Collision: %u queries, %u pairs, %u hits, %u rays",
+			stats->broadphase_queries, stats->pairs_tested, stats->narrowphase_hits, stats->raycasts
+		),
+		x, y + 3 * font_size, font_size, WHITE
+	);
+	DrawText(
+		TextFormat(
+			"Renderables: %u submitted, %u culled, %u drawn, %u sorted, %u state changes",
+			stats->renderables_submitted, stats->renderables_culled,
+			stats->renderables_drawn, stats->transparent_sorted, stats->render_state_changes
+		),
+		x, y + 4 * font_size, font_size, WHITE
+	);
+	DrawText(
+		TextFormat(
+			"Instancing: %u batches, %u occluded, %u over budget",
+			stats->instanced_batches, stats->renderables_occluded, stats->renderables_dropped
+		),
+		x, y + 5 * font_size, font_size, WHITE
+	);
+	DrawText(TextFormat("Allocations: %u", stats->allocations), x, y + 6 * font_size, font_size, WHITE);
+}
+
 /**********************
 	PRIVATE METHODS
 **********************/
@@ -459,6 +1078,7 @@ void
 Engine__insertHead(Engine *self, Head *head)
 {
 	if (MAX_NUM_HEADS <= self->head_count) return;
+	head->index = self->head_count;
 	if (!self->heads) {
 		self->heads = head;
 		self->head_count++;
@@ -490,6 +1110,17 @@ Engine__removeHead(Engine *self, Head *head)
 	if (self->heads == head) self->heads = head_2;
 	
 	self->head_count--;
+	
+	/* Keep indices contiguous */
+	if (!self->head_count) {
+		self->heads = NULL;
+		return;
+	}
+	Head *current = self->heads;
+	for (uint8 i = 0; i < self->head_count; i++) {
+		current->index = i;
+		current        = current->next;
+	}
 }
 
 Scene *
@@ -534,3 +1165,35 @@ Engine__getRenderer(Engine *self)
 {
 	return self->renderer;
 }
+
+EngineStats *
+Engine__getStats(Engine *self)
+{
+	return &self->stats;
+}
+
+/*
+	Which update bucket a position falls in, going by the nearest Head.
+	Heads aren't updated in a replay, so recordings update everything.
+*/
+uint8
+Engine__getUpdateBucket(Engine *self, Vector3 position)
+{
+	if (!self->heads || self->recording || self->replaying) return 0;
+	
+	float nearest_sq = INFINITY;
+	Head *head       = self->heads;
+	do {
+		float dist_sq = Vector3DistanceSqr(position, head->camera.position);
+		if (dist_sq < nearest_sq) nearest_sq = dist_sq;
+		head = head->next;
+	} while (head != self->heads);
+	
+	uint8 bucket = 0;
+	while (
+		bucket < UPDATE_LOD_LEVELS - 1
+		&& self->update_lod_distances[bucket] < nearest_sq
+	) bucket++;
+	
+	return bucket;
+}
@@ -1,5 +1,6 @@
 #include <raylib.h>
 #include <raymath.h>
+#include <string.h>
 
 #include "_engine_.h"
 #include "_entity_.h"
@@ -13,7 +14,8 @@
 #define SEPARATION_EPSILON 0.01f
 
 
-static uint64 Latest_ID = 0;
+static uint64            Latest_ID = 0;
+static EntityArchetype **Archetypes = NULL;
 
 
 static void
@@ -30,23 +32,34 @@ setCollisionState(EntityNode *node, CollisionResult *collision)
 }
 
 
-/******************
-	CONSTRUCTOR
-******************/
-Entity *
-Entity_new(const Entity *template, Engine *engine, size_t user_data_size)
+/*************************
+	ARCHETYPE REGISTRY
+*************************/
+/* Make an archetype findable by name, e.g. by map loaders. It must outlive its Entities. */
+void
+EntityArchetype_register(EntityArchetype *archetype)
 {
-	if (!engine) return NULL;
+	if (!Archetypes) Archetypes = DynamicArray(EntityArchetype*, 16);
+	if (EntityArchetype_find(archetype->name)) return;
 	
-	EntityNode *node = malloc(
-			sizeof(EntityNode) 
-				+ user_data_size
-		);
+	DynamicArray_add(Archetypes, archetype);
+}
 
-	if (!node) {
-		ERR_OUT("Failed to allocate memory for EntityNode.");
-		return NULL;
+EntityArchetype *
+EntityArchetype_find(const char *name)
+{
+	if (!Archetypes || !name) return NULL;
+	
+	for (size_t i = 0; i < DynamicArray_length(Archetypes); i++) {
+		if (Archetypes[i]->name && !strcmp(Archetypes[i]->name, name)) return Archetypes[i];
 	}
+	return NULL;
+}
+
+
+static void
+initNode(EntityNode *node, const Entity *template, Engine *engine, size_t user_data_size)
+{
 	Entity *entity = NODE_TO_ENTITY(node);
 	*entity                 = *template;
 	entity->user_data       =  NULL;
@@ -58,11 +71,40 @@ Entity_new(const Entity *template, Engine *engine, size_t user_data_size)
 	node->next          = node;
 	node->prev          = node;
 	node->engine        = engine;
+	node->batch         = NULL;
 	node->size          = sizeof(EntityNode) + user_data_size;
 	node->flags         = 0;
-	node->unique_ID     = Latest_ID++;
+	node->update_delta   = 0.0f;
+	node->snapshot_index = ENTITY_NO_SNAPSHOT;
+	node->view_index[0]  = ENTITY_NO_SNAPSHOT;
+	node->view_index[1]  = ENTITY_NO_SNAPSHOT;
+	node->unique_ID      = Latest_ID++;
+	for (int i = 0; i < MAX_NUM_HEADS; i++) node->current_lod[i] = -1;
 	node->scene         = NULL;
 	node->creation_time = Engine_getTime(engine);
+}
+
+
+/******************
+	CONSTRUCTOR
+******************/
+Entity *
+Entity_new(const Entity *template, Engine *engine, size_t user_data_size)
+{
+	if (!engine) return NULL;
+	
+	EntityNode *node = malloc(
+			sizeof(EntityNode) 
+				+ user_data_size
+		);
+
+	if (!node) {
+		ERR_OUT("Failed to allocate memory for EntityNode.");
+		return NULL;
+	}
+	ENGINE_STAT_ADD(engine, allocations, 1);
+	initNode(node, template, engine, user_data_size);
+	Entity *entity = NODE_TO_ENTITY(node);
 	
 //	Engine__insertEntity(engine, node);
 	
@@ -72,6 +114,76 @@ Entity_new(const Entity *template, Engine *engine, size_t user_data_size)
 	return entity;
 }
 
+/*
+	Creates count Entities from one template in a single allocation and adds
+	them all to scene. positions may be NULL, otherwise it holds count
+	positions which are set before Setup is called.
+	Returns a DynamicArray of the new Entities, to be freed by the caller.
+*/
+Entity **
+Entity_newBatch(
+	const Entity  *template,
+	uint           count,
+	const Vector3 *positions,
+	size_t         user_data_size,
+	Scene         *scene
+)
+{
+	if (!scene || !count) return NULL;
+	
+	Engine *engine = Scene_getEngine(scene);
+	size_t
+		align  = _Alignof(max_align_t),
+		header = (sizeof(EntityBatch) + align - 1) & ~(align - 1),
+		stride = (sizeof(EntityNode) + user_data_size + align - 1) & ~(align - 1);
+	
+	EntityBatch *batch    = malloc(header + stride * count);
+	Entity     **entities = DynamicArray(Entity*, count + 1);
+	if (!batch || !entities) {
+		ERR_OUT("Failed to allocate memory for EntityNode batch.");
+		free(batch);
+		if (entities) DynamicArray_free(entities);
+		return NULL;
+	}
+	batch->refs = count;
+	ENGINE_STAT_ADD(engine, allocations, 1);
+	
+	char *block = (char*)batch + header;
+	for (uint i = 0; i < count; i++) {
+		EntityNode *node = (EntityNode*)(block + stride * i);
+		initNode(node, template, engine, user_data_size);
+		node->batch = batch;
+		if (positions) node->base.position = positions[i];
+		
+		Entity *entity = NODE_TO_ENTITY(node);
+		DynamicArray_add(entities, entity);
+	}
+	
+	EntityVTable *vtable = template->vtable;
+	if (vtable && vtable->Setup) {
+		for (uint i = 0; i < count; i++) vtable->Setup(entities[i]);
+	}
+	
+	/* +1 since DynamicArray_append() grows when it would become full */
+	DynamicArray_reserve(
+			(void**)&scene->entity_list, 
+			DynamicArray_length(scene->entity_list) + count + 1
+		);
+	DynamicArray_concat((void**)&scene->entity_list, entities);
+	for (uint i = 0; i < count; i++) {
+		ENTITY_TO_NODE(entities[i])->scene = scene;
+		Scene__indexEntity(scene, entities[i]);
+	}
+	
+	for (uint i = 0; i < count; i++) {
+		Entity *entity = entities[i];
+		vtable = entity->vtable;
+		if (vtable && vtable->Enter) vtable->Enter(entity);
+	}
+	
+	return entities;
+}
+
 void
 Entity_free(Entity *self)
 {
@@ -84,7 +196,10 @@ double
 Entity_getAge(Entity *self)
 {
 	EntityNode *node = ENTITY_TO_NODE(self);
-	return Engine_getTime(node->engine) - node->creation_time;
+	double      age  = Engine_getTime(node->engine) - node->creation_time;
+	
+	/* Spawned by a frame a little past the tick now asking */
+	return (age < 0.0) ? 0.0 : age;
 }
 
 BoundingBox
@@ -113,17 +228,123 @@ Entity_getBoundingBox(Entity *entity)
 Renderable *
 Entity_getLODRenderable(Entity *entity, Vector3 position, Vector3 camera_position)
 {
-	float distance = Vector3Distance(position, camera_position);
+	const EntityArchetype *archetype = entity->archetype;
+	if (!archetype) return NULL;
+	
+	float dist_sq = Vector3DistanceSqr(position, camera_position);
 	
 	int lod_level  = -1;
-	for (int i = 0; i < entity->lod_count; i++) {
-		if (entity->lod_distances[i] < distance) continue;
+	for (int i = 0; i < archetype->lod_count; i++) {
+		if (archetype->lod_distances[i] * archetype->lod_distances[i] < dist_sq) continue;
 		lod_level = i;
 		break;
 	}
 	if (lod_level < 0) return NULL; /* Distance is greater than max renderable LOD level, so don't render it. */
 	
-	return entity->renderables[lod_level];
+	return archetype->renderables[lod_level];
+}
+
+/* entity's record in its Scene's front view, or NULL if it has none */
+static const EntityRenderState *
+getViewState(Entity *entity)
+{
+	EntityNode *node  = ENTITY_TO_NODE(entity);
+	Scene      *scene = node->scene;
+	
+	if (!scene || !scene->has_view) return NULL;
+	
+	SceneView *view  = &scene->views[scene->front_view];
+	uint32     index = node->view_index[scene->front_view];
+	
+	if (DynamicArray_length(view->entities) <= index || view->entities[index] != entity) return NULL;
+	
+	return &view->states[index];
+}
+
+/* 
+	Transform between the previous and current tick, for rendering. In
+	pipelined mode this comes from the Scene's front view, not the live
+	Entity, which the next tick is busy changing.
+*/
+Transform
+Entity_getRenderTransform(Entity *entity)
+{
+	EntityNode *node  = ENTITY_TO_NODE(entity);
+	Scene      *scene = node->scene;
+	Transform   prev,
+	            current;
+	float       t;
+	
+	if (scene && scene->has_view) {
+		const EntityRenderState *state = getViewState(entity);
+		if (!state) return entity->transform;
+		
+		prev    = state->prev_transform;
+		current = state->transform;
+		t       = CLAMP(scene->views[scene->front_view].tick_elapsed, 0.0f, 1.0f);
+		
+		if (!state->interpolate) return current;
+	}
+	else {
+		if (
+			!entity->interpolate 
+			|| !scene
+			|| DynamicArray_length(scene->prev_transforms) <= node->snapshot_index
+		) 
+			return entity->transform;
+		
+		prev    = scene->prev_transforms[node->snapshot_index];
+		current = entity->transform;
+		t       = CLAMP(Engine_getTickElapsed(node->engine), 0.0f, 1.0f);
+	}
+	
+	return (Transform){
+			.translation = Vector3Lerp(prev.translation, current.translation, t),
+			.rotation    = QuaternionNlerp(prev.rotation, current.rotation, t),
+			.scale       = Vector3Lerp(prev.scale, current.scale, t)
+		};
+}
+
+/*
+	Model matrix placing entity's renderable at position, as one instance
+	of a RenderInstanced() batch: scaled, then rotated, then moved by
+	renderable_offset and position, matching a per-Entity draw.
+*/
+Matrix
+Entity_getInstanceTransform(Entity *entity, Vector3 position)
+{
+	const EntityRenderState *state     = getViewState(entity);
+	Transform                transform = Entity_getRenderTransform(entity);
+	Vector3                  offset    = Vector3Add(
+			position, 
+			state ? state->renderable_offset : entity->renderable_offset
+		);
+	
+	return MatrixMultiply(
+			MatrixMultiply(
+				MatrixScale(transform.scale.x, transform.scale.y, transform.scale.z),
+				QuaternionToMatrix(transform.rotation)
+			),
+			MatrixTranslate(offset.x, offset.y, offset.z)
+		);
+}
+
+/* bounds as of the Transform Entity_getRenderTransform() gives */
+Vector3
+Entity_getRenderBounds(Entity *entity)
+{
+	const EntityRenderState *state = getViewState(entity);
+	return state ? state->bounds : entity->bounds;
+}
+
+/* current_anim, and anim_frame through anim_frame, to draw entity with */
+int
+Entity_getRenderAnimation(Entity *entity, int *anim_frame)
+{
+	const EntityRenderState *state = getViewState(entity);
+	if (anim_frame) *anim_frame = state ? state->anim_frame : entity->anim_frame;
+	
+	return state ? state->current_anim : entity->current_anim;
 }
 
 Engine *
@@ -156,6 +377,19 @@ Entity_getUniqueID(Entity *entity)
 	return ENTITY_TO_NODE(entity)->unique_ID;
 }
 
+/* The ID the next Entity will get, saved and restored by Scene snapshots */
+uint64
+Entity__getNextID(void)
+{
+	return Latest_ID;
+}
+
+void
+Entity__setNextID(uint64 unique_ID)
+{
+	Latest_ID = unique_ID;
+}
+
 bool
 Entity_isOnFloor(Entity *self)
 {
@@ -172,7 +406,9 @@ Entity_addToScene(Entity *self, Scene *scene)
 	if (node->scene)  Entity_removeFromScene(self);
 	
 	DynamicArray_add(scene->entity_list, self);
-	node->scene = scene;
+	Scene__indexEntity(scene, self);
+	node->scene          = scene;
+	node->snapshot_index = ENTITY_NO_SNAPSHOT;
 
 	if (vtable && vtable->Enter) vtable->Enter(self);
 }
@@ -193,12 +429,74 @@ Entity_removeFromScene(Entity *self)
 	    DynamicArray_delete(scene->entity_list, i, 1);
 	    break;
 	}
+	Scene__unindexEntity(scene, self);
 	
 	node->scene = NULL;
 	
 	if (vtable && vtable->Exit) vtable->Exit(self);
 }
 
+/*
+	Deferred commands
+		Safe to call from a ParallelUpdate callback; they are run in a fixed
+		order once every entity's ParallelUpdate has returned. Anywhere else
+		they run immediately.
+*/
+void
+Entity_deferSpawn(
+	Entity              *self, 
+	const Entity        *template, 
+	size_t               user_data_size, 
+	Vector3              position, 
+	EntitySpawnCallback  on_spawn
+)
+{
+	EntityNode      *node    = ENTITY_TO_NODE(self);
+	DeferredCommand  command = {
+			.type            = DEFERRED_SPAWN,
+			.issuer_ID       = node->unique_ID,
+			.issuer          = self,
+			.template_entity = template,
+			.user_data_size  = user_data_size,
+			.on_spawn        = on_spawn,
+			.vector          = position,
+		};
+	
+	Scene__defer(node->scene, &command);
+}
+
+/* Frees target, or the Entity itself if target is NULL */
+void
+Entity_deferFree(Entity *self, Entity *target)
+{
+	EntityNode      *node    = ENTITY_TO_NODE(self);
+	DeferredCommand  command = {
+			.type      = DEFERRED_FREE,
+			.issuer_ID = node->unique_ID,
+			.issuer    = self,
+			.target    = target ? target : self,
+		};
+	
+	Scene__defer(node->scene, &command);
+}
+
+void
+Entity_deferMove(Entity *self, Vector3 movement, bool slide)
+{
+	EntityNode      *node    = ENTITY_TO_NODE(self);
+	DeferredCommand  command = {
+			.type      = slide ? DEFERRED_MOVE_AND_SLIDE : DEFERRED_MOVE,
+			.issuer_ID = node->unique_ID,
+			.issuer    = self,
+			.vector    = movement,
+		};
+	
+	if (!node->scene) return;
+	
+	Scene__defer(node->scene, &command);
+}
+
+
 CollisionResult
 move(Entity *self, Vector3 movement)
 {
@@ -300,12 +598,74 @@ Entity_teleport(Entity *entity, Vector3  to)
 	EntityVTable *vtable = entity->vtable;
 	if (vtable && vtable->Teleport) vtable->Teleport(entity, entity->position, to);
 	entity->position = to;
+	/* Don't interpolate across the teleport */
+	ENTITY_TO_NODE(entity)->snapshot_index = ENTITY_NO_SNAPSHOT;
 }
 
 
 /*
 	Private Methods
 */
+/*
+	What the renderer may read of entity: its front view's copy when
+	pipelined, otherwise the live Entity. The transforms are the last
+	tick's, not interpolated.
+*/
+EntityRenderState
+Entity__getRenderState(Entity *entity)
+{
+	const EntityRenderState *state = getViewState(entity);
+	if (state) return *state;
+	
+	return (EntityRenderState){
+			.prev_transform    = entity->transform,
+			.transform         = entity->transform,
+			.archetype         = entity->archetype,
+			.bounds            = entity->bounds,
+			.renderable_offset = entity->renderable_offset,
+			.visibility_radius = entity->visibility_radius,
+			.current_anim      = entity->current_anim,
+			.anim_frame        = entity->anim_frame,
+			.visible           = entity->visible,
+			.interpolate       = entity->interpolate
+		};
+}
+
+/* 
+	Pick the LOD level for a Head, sticking with the one it picked last time
+	until dist_sq is LOD_HYSTERESIS past the boundary. Returns -1 if out of range.
+	archetype is passed in since entity's own may be changing, see
+	Entity__getRenderState().
+*/
+int
+Entity__selectLOD(Entity *entity, const EntityArchetype *archetype, uint8 head_index, float dist_sq)
+{
+	if (!archetype) return -1;
+	
+	EntityNode  *node      = ENTITY_TO_NODE(entity);
+	const float *distances = archetype->lod_distances;
+	int          lod_count = archetype->lod_count;
+	int          current   = node->current_lod[head_index];
+	int          level     = 0;
+	
+	while (level < lod_count && distances[level] * distances[level] < dist_sq) level++;
+	
+	if (0 <= current && current <= lod_count && level != current) {
+		float band;
+		if (current < level) { /* Coarser: must get far enough past the current level's range */
+			band = distances[current] * (1.0f + LOD_HYSTERESIS);
+			if (dist_sq <= band * band) level = current;
+		}
+		else { /* Finer: must get far enough inside the next finer level's range */
+			band = distances[current - 1] * (1.0f - LOD_HYSTERESIS);
+			if (band * band <= dist_sq) level = current;
+		}
+	}
+	node->current_lod[head_index] = level;
+	
+	return (level < lod_count) ? level : -1;
+}
+
 void
 EntityNode__free(EntityNode *self)
 {
@@ -316,7 +676,12 @@ EntityNode__free(EntityNode *self)
 	
 //	Engine__removeEntity(self->engine, self);
 
-	free(self);
+	EntityBatch *batch = self->batch;
+	if (!batch) {
+		free(self);
+		return;
+	}
+	if (--batch->refs == 0) free(batch);
 }
 
 void
@@ -0,0 +1,203 @@
+#include <string.h>
+
+#include "frustum.h"
+
+
+/* Widest vector unit the compiler was told it may use; the rest run scalar */
+#if !defined(KOLIBRI_NO_SIMD) && defined(__AVX__)
+	#include <immintrin.h>
+
+	#define LANES 8
+	typedef __m256 Lanes;
+
+	#define LOAD(  pointer ) _mm256_loadu_ps(pointer)
+	#define SPLAT( value )   _mm256_set1_ps(value)
+	#define ADD(   a, b )    _mm256_add_ps(a, b)
+	#define MUL(   a, b )    _mm256_mul_ps(a, b)
+	#define AND(   a, b )    _mm256_and_ps(a, b)
+	#define NOT_BEHIND( a )  _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_GE_OQ)
+	#define BITS(  a )       ((uint32)_mm256_movemask_ps(a))
+#elif !defined(KOLIBRI_NO_SIMD) && (defined(__SSE__) || defined(_M_X64))
+	#include <xmmintrin.h>
+
+	#define LANES 4
+	typedef __m128 Lanes;
+
+	#define LOAD(  pointer ) _mm_loadu_ps(pointer)
+	#define SPLAT( value )   _mm_set1_ps(value)
+	#define ADD(   a, b )    _mm_add_ps(a, b)
+	#define MUL(   a, b )    _mm_mul_ps(a, b)
+	#define AND(   a, b )    _mm_and_ps(a, b)
+	#define NOT_BEHIND( a )  _mm_cmpge_ps(a, _mm_setzero_ps())
+	#define BITS(  a )       ((uint32)_mm_movemask_ps(a))
+#else
+	#define LANES 1
+#endif
+
+
+static inline bool
+isSphereBehindPlane(const Plane *plane, Vector3 center, float radius)
+{
+	float distance = Vector3DotProduct(plane->normal, center) + plane->distance;
+	return distance < -radius;
+}
+
+bool
+isSphereInFrustum(
+	Vector3  center,
+	float    radius,
+	Frustum *frustum
+)
+{
+    /* Test against frustum planes efficiently */
+    for (int i = FRUSTUM_LEFT; i <= FRUSTUM_FAR; i++) {
+        if (isSphereBehindPlane(&frustum->planes[i], center, radius)) return false;
+    }
+
+    return true;
+}
+
+bool
+isAABBInFrustum(
+    Vector3  center,
+    Vector3  extents,
+    Frustum *frustum,
+    float    dist_sq,
+    float    max_distance
+)
+{
+    /* Quick distance check first (using squared distance) */
+    float max_dist_check = max_distance + Vector3Length(extents);
+    if (dist_sq > max_dist_check * max_dist_check) {
+        return false;
+    }
+
+    /* Test against each frustum plane */
+    for (int i = FRUSTUM_LEFT; i <= FRUSTUM_FAR; i++) {
+        const Plane *plane = &frustum->planes[i];
+
+        /* Calculate the effective radius of the box along the plane normal */
+        float radius = fabsf(extents.x * plane->normal.x)
+            + fabsf(extents.y * plane->normal.y)
+            + fabsf(extents.z * plane->normal.z);
+
+        /* Distance from center to plane */
+        float distance = Vector3DotProduct(plane->normal, center) + plane->distance;
+
+        /* If center is further than radius behind plane, box is completely outside */
+        if (distance < -radius) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+void
+cullSpheresInFrustum(
+	const Frustum *frustum,
+	const float   *x,
+	const float   *y,
+	const float   *z,
+	const float   *radius,
+	uint           count,
+	uint32        *visible
+)
+{
+	const Plane *planes = frustum->planes;
+	uint         i      = 0;
+
+	memset(visible, 0, FRUSTUM_MASK_WORDS(count) * sizeof(uint32));
+
+#if 1 < LANES
+	Lanes nx[6], ny[6], nz[6], nd[6];
+	for (int p = 0; p < 6; p++) {
+		nx[p] = SPLAT(planes[p].normal.x);
+		ny[p] = SPLAT(planes[p].normal.y);
+		nz[p] = SPLAT(planes[p].normal.z);
+		nd[p] = SPLAT(planes[p].distance);
+	}
+
+	/* LANES divides 32, so a batch never straddles two mask words */
+	for (; i + LANES <= count; i += LANES) {
+		Lanes px = LOAD(x + i), py = LOAD(y + i), pz = LOAD(z + i), r = LOAD(radius + i);
+		Lanes inside = SPLAT(0.0f);
+
+		for (int p = 0; p < 6; p++) {
+			Lanes distance = ADD(ADD(MUL(nx[p], px), ADD(MUL(ny[p], py), MUL(nz[p], pz))), ADD(nd[p], r));
+			inside = p ? AND(inside, NOT_BEHIND(distance)) : NOT_BEHIND(distance);
+		}
+		visible[i / 32] |= BITS(inside) << (i % 32);
+	}
+#endif
+
+	for (; i < count; i++) {
+		bool inside = true;
+		for (int p = 0; p < 6 && inside; p++) {
+			inside = 0.0f <= planes[p].normal.x * x[i]
+				+ planes[p].normal.y * y[i]
+				+ planes[p].normal.z * z[i]
+				+ planes[p].distance + radius[i];
+		}
+		if (inside) visible[i / 32] |= 1u << (i % 32);
+	}
+}
+
+void
+cullAABBsInFrustum(
+	const Frustum *frustum,
+	const float   *x,
+	const float   *y,
+	const float   *z,
+	const float   *extent_x,
+	const float   *extent_y,
+	const float   *extent_z,
+	uint           count,
+	uint32        *visible
+)
+{
+	const Plane *planes = frustum->planes;
+	uint         i      = 0;
+
+	memset(visible, 0, FRUSTUM_MASK_WORDS(count) * sizeof(uint32));
+
+#if 1 < LANES
+	Lanes nx[6], ny[6], nz[6], nd[6], ax[6], ay[6], az[6];
+	for (int p = 0; p < 6; p++) {
+		nx[p] = SPLAT(planes[p].normal.x);
+		ny[p] = SPLAT(planes[p].normal.y);
+		nz[p] = SPLAT(planes[p].normal.z);
+		nd[p] = SPLAT(planes[p].distance);
+		ax[p] = SPLAT(fabsf(planes[p].normal.x));
+		ay[p] = SPLAT(fabsf(planes[p].normal.y));
+		az[p] = SPLAT(fabsf(planes[p].normal.z));
+	}
+
+	for (; i + LANES <= count; i += LANES) {
+		Lanes
+			px = LOAD(x + i),        py = LOAD(y + i),        pz = LOAD(z + i),
+			ex = LOAD(extent_x + i), ey = LOAD(extent_y + i), ez = LOAD(extent_z + i);
+		Lanes inside = SPLAT(0.0f);
+
+		for (int p = 0; p < 6; p++) {
+			/* The box's extent along the normal stands in for a radius */
+			Lanes reach    = ADD(MUL(ax[p], ex), ADD(MUL(ay[p], ey), MUL(az[p], ez)));
+			Lanes distance = ADD(ADD(MUL(nx[p], px), ADD(MUL(ny[p], py), MUL(nz[p], pz))), ADD(nd[p], reach));
+			inside = p ? AND(inside, NOT_BEHIND(distance)) : NOT_BEHIND(distance);
+		}
+		visible[i / 32] |= BITS(inside) << (i % 32);
+	}
+#endif
+
+	for (; i < count; i++) {
+		bool inside = true;
+		for (int p = 0; p < 6 && inside; p++) {
+			const Vector3 normal = planes[p].normal;
+			float reach = fabsf(normal.x) * extent_x[i] + fabsf(normal.y) * extent_y[i] + fabsf(normal.z) * extent_z[i];
+
+			inside = 0.0f <= normal.x * x[i] + normal.y * y[i] + normal.z * z[i] + planes[p].distance + reach;
+		}
+		if (inside) visible[i / 32] |= 1u << (i % 32);
+	}
+}
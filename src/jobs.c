@@ -0,0 +1,490 @@
+#include <string.h>
+
+#include "_jobs_.h"
+
+#ifndef KOLIBRI_NO_THREADS
+	#include <sched.h>
+	#if defined(__unix__) || defined(__APPLE__)
+		#include <unistd.h>
+	#endif
+#endif
+
+
+#define NO_JOB UINT32_MAX
+#define QUEUE_SLOT( queue, i ) ((queue)->indices[(i) & (JOB_POOL_SIZE - 1)])
+
+
+#ifndef KOLIBRI_NO_THREADS
+
+typedef struct
+ParallelFor
+{
+	JobRangeFunction function;
+	void            *data;
+	uint             count,
+	                 batch_size;
+	_Atomic uint     next;
+}
+ParallelFor;
+
+
+static _Thread_local JobSystem *thread_system = NULL;
+static _Thread_local uint       thread_index  = 0;
+
+
+static uint
+cpuCount(void)
+{
+#if defined(_SC_NPROCESSORS_ONLN)
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 0) ? (uint)count : 1;
+#else
+	return 1;
+#endif
+}
+
+
+static inline uint
+currentThread(JobSystem *self)
+{
+	return (thread_system == self) ? thread_index : 0;
+}
+
+
+static void
+pushJob(JobSystem *self, uint32 index)
+{
+	JobQueue *queue = &self->queues[currentThread(self)];
+
+	pthread_mutex_lock(&queue->lock);
+		QUEUE_SLOT(queue, queue->bottom++) = index;
+	pthread_mutex_unlock(&queue->lock);
+
+	atomic_fetch_add(&self->queued, 1);
+	pthread_mutex_lock(&self->sleep_lock);
+		pthread_cond_signal(&self->work_available);
+	pthread_mutex_unlock(&self->sleep_lock);
+}
+
+
+/* Newest job from our own queue first, otherwise the oldest from another */
+static uint32
+findJob(JobSystem *self)
+{
+	uint   current = currentThread(self);
+	uint32 index   = NO_JOB;
+
+	for (uint i = 0; i < self->thread_count && index == NO_JOB; i++) {
+		JobQueue *queue = &self->queues[(current + i) % self->thread_count];
+
+		pthread_mutex_lock(&queue->lock);
+		if (queue->top != queue->bottom) {
+			index = (i == 0)
+				? QUEUE_SLOT(queue, --queue->bottom)
+				: QUEUE_SLOT(queue, queue->top++);
+		}
+		pthread_mutex_unlock(&queue->lock);
+	}
+
+	if (index != NO_JOB) atomic_fetch_sub(&self->queued, 1);
+
+	return index;
+}
+
+
+static void
+runJob(JobSystem *self, uint32 index)
+{
+	Job   *job = &self->pool[index];
+	uint32 dependents[JOB_MAX_DEPENDENTS];
+	uint   dependent_count;
+
+	job->function(job->data);
+
+	pthread_mutex_lock(&self->graph_lock);
+		dependent_count = job->dependent_count;
+		memcpy(dependents, job->dependents, dependent_count * sizeof(uint32));
+		job->dependent_count = 0;
+		job->next_free       = self->free_head;
+		self->free_head      = index;
+		atomic_fetch_add(&job->generation, 1);
+	pthread_mutex_unlock(&self->graph_lock);
+
+	for (uint i = 0; i < dependent_count; i++) {
+		if (atomic_fetch_sub(&self->pool[dependents[i]].pending, 1) == 1)
+			pushJob(self, dependents[i]);
+	}
+}
+
+
+static bool
+runOneJob(JobSystem *self)
+{
+	uint32 index = findJob(self);
+	if (index == NO_JOB) return false;
+
+	runJob(self, index);
+	return true;
+}
+
+
+/*
+	Run one of a parallelFor's own helpers if it is still on top of our queue.
+	Waiting on helpers must not pick up unrelated jobs, e.g. a long tick job
+	submitted just before, or the caller would stall until that finishes.
+*/
+static bool
+runOwnHelper(JobSystem *self, void *range)
+{
+	JobQueue *queue = &self->queues[currentThread(self)];
+	uint32    index = NO_JOB;
+
+	pthread_mutex_lock(&queue->lock);
+	if (queue->top != queue->bottom && self->pool[QUEUE_SLOT(queue, queue->bottom - 1)].data == range)
+		index = QUEUE_SLOT(queue, --queue->bottom);
+	pthread_mutex_unlock(&queue->lock);
+
+	if (index == NO_JOB) return false;
+
+	atomic_fetch_sub(&self->queued, 1);
+	runJob(self, index);
+	return true;
+}
+
+
+static void *
+workerMain(void *data)
+{
+	JobQueue  *queue = data;
+	JobSystem *self  = queue->owner;
+
+	thread_system = self;
+	thread_index  = (uint)(queue - self->queues);
+
+	while (!atomic_load(&self->shutdown)) {
+		if (runOneJob(self)) continue;
+
+		pthread_mutex_lock(&self->sleep_lock);
+		while (!atomic_load(&self->shutdown) && !atomic_load(&self->queued))
+			pthread_cond_wait(&self->work_available, &self->sleep_lock);
+		pthread_mutex_unlock(&self->sleep_lock);
+	}
+
+	return NULL;
+}
+
+
+static void
+runParallelFor(void *data)
+{
+	ParallelFor *range = data;
+	uint         start;
+
+	while ((start = atomic_fetch_add(&range->next, range->batch_size)) < range->count) {
+		uint end = start + range->batch_size;
+		if (end > range->count) end = range->count;
+
+		range->function(range->data, start, end);
+	}
+}
+
+#endif /* !KOLIBRI_NO_THREADS */
+
+
+/******************************
+	CONSTRUCTOR/DESTRUCTOR
+******************************/
+/*
+	A thread_count of 0 uses one thread per CPU. The calling thread counts as
+	one of them, and only runs jobs while it waits on them.
+*/
+JobSystem *
+JobSystem_new(uint thread_count)
+{
+	JobSystem *jobs = malloc(sizeof(JobSystem));
+
+	if (!jobs) {
+		ERR_OUT("Failed to allocate memory for JobSystem.");
+		return NULL;
+	}
+	*jobs = (JobSystem){0};
+
+#ifdef KOLIBRI_NO_THREADS
+	(void)thread_count;
+	jobs->thread_count = 1;
+#else
+	if (!thread_count)                  thread_count = cpuCount();
+	if (thread_count > JOB_MAX_THREADS) thread_count = JOB_MAX_THREADS;
+
+	jobs->thread_count = thread_count;
+	jobs->pool         = malloc(sizeof(Job) * JOB_POOL_SIZE);
+	jobs->queues       = calloc(thread_count, sizeof(JobQueue));
+	jobs->threads      = calloc(thread_count, sizeof(pthread_t));
+	uint32 *indices    = malloc(sizeof(uint32) * JOB_POOL_SIZE * thread_count);
+
+	if (!jobs->pool || !jobs->queues || !jobs->threads || !indices) {
+		ERR_OUT("Failed to allocate memory for JobSystem.");
+		free(jobs->pool);
+		free(jobs->queues);
+		free(jobs->threads);
+		free(indices);
+		free(jobs);
+		return NULL;
+	}
+
+	for (uint32 i = 0; i < JOB_POOL_SIZE; i++) {
+		atomic_init(&jobs->pool[i].generation, 0);
+		atomic_init(&jobs->pool[i].pending,    0);
+		jobs->pool[i].dependent_count = 0;
+		jobs->pool[i].next_free       = (i + 1 < JOB_POOL_SIZE) ? i + 1 : NO_JOB;
+	}
+	jobs->free_head = 0;
+
+	pthread_mutex_init(&jobs->graph_lock, NULL);
+	pthread_mutex_init(&jobs->sleep_lock, NULL);
+	pthread_cond_init(&jobs->work_available, NULL);
+	atomic_init(&jobs->queued,   0);
+	atomic_init(&jobs->shutdown, false);
+
+	for (uint i = 0; i < thread_count; i++) {
+		pthread_mutex_init(&jobs->queues[i].lock, NULL);
+		jobs->queues[i].indices = indices + (i * JOB_POOL_SIZE);
+		jobs->queues[i].owner   = jobs;
+	}
+
+	thread_system = jobs;
+	thread_index  = 0;
+
+	for (uint i = 1; i < thread_count; i++) {
+		if (pthread_create(&jobs->threads[i], NULL, workerMain, &jobs->queues[i])) {
+			ERR_OUT("Failed to start JobSystem worker thread.");
+			jobs->thread_count = i;
+			break;
+		}
+	}
+#endif /* KOLIBRI_NO_THREADS */
+
+	return jobs;
+}
+
+
+/* Jobs still queued are dropped, so wait on anything that must finish */
+void
+JobSystem_free(JobSystem *self)
+{
+	if (!self) return;
+
+#ifndef KOLIBRI_NO_THREADS
+	atomic_store(&self->shutdown, true);
+	pthread_mutex_lock(&self->sleep_lock);
+		pthread_cond_broadcast(&self->work_available);
+	pthread_mutex_unlock(&self->sleep_lock);
+
+	for (uint i = 1; i < self->thread_count; i++)
+		pthread_join(self->threads[i], NULL);
+
+	for (uint i = 0; i < self->thread_count; i++)
+		pthread_mutex_destroy(&self->queues[i].lock);
+
+	pthread_mutex_destroy(&self->graph_lock);
+	pthread_mutex_destroy(&self->sleep_lock);
+	pthread_cond_destroy(&self->work_available);
+
+	if (thread_system == self) thread_system = NULL;
+
+	free(self->queues[0].indices);
+	free(self->queues);
+	free(self->threads);
+	free(self->pool);
+#endif /* !KOLIBRI_NO_THREADS */
+	free(self);
+}
+
+
+/************************
+	SETTERS/GETTERS
+************************/
+uint
+JobSystem_getThreadCount(JobSystem *self)
+{
+	return self->thread_count;
+}
+
+
+/* 0 for the creating thread (or any thread outside the pool), 1+ for workers */
+uint
+JobSystem_getThreadIndex(JobSystem *self)
+{
+#ifdef KOLIBRI_NO_THREADS
+	(void)self;
+	return 0;
+#else
+	return currentThread(self);
+#endif
+}
+
+
+/**************
+	METHODS
+**************/
+/*
+	Queues function(data) to run once every job in dependencies has finished.
+	With only one thread there is nobody to hand it to, so it runs right away.
+*/
+JobHandle
+JobSystem_submit(
+	JobSystem       *self,
+	JobFunction      function,
+	void            *data,
+	const JobHandle *dependencies,
+	uint             dependency_count
+)
+{
+#ifdef KOLIBRI_NO_THREADS
+	(void)dependencies;
+	(void)dependency_count;
+#else
+	if (self->thread_count > 1) {
+		uint32 index;
+
+		pthread_mutex_lock(&self->graph_lock);
+		/* Pool exhausted: make ourselves useful until a slot frees up */
+		while ((index = self->free_head) == NO_JOB) {
+			pthread_mutex_unlock(&self->graph_lock);
+			if (!runOneJob(self)) sched_yield();
+			pthread_mutex_lock(&self->graph_lock);
+		}
+
+		Job *job        = &self->pool[index];
+		self->free_head = job->next_free;
+		job->function   = function;
+		job->data       = data;
+		job->next_free  = NO_JOB;
+		atomic_store(&job->pending, 1);
+
+		JobHandle handle = {index, atomic_load(&job->generation)};
+
+		for (uint i = 0; i < dependency_count; i++) {
+			JobHandle dependency = dependencies[i];
+			if (dependency.index >= JOB_POOL_SIZE) continue;
+
+			Job *parent = &self->pool[dependency.index];
+			while (
+				atomic_load(&parent->generation) == dependency.generation
+				&& parent->dependent_count >= JOB_MAX_DEPENDENTS
+			) {
+				pthread_mutex_unlock(&self->graph_lock);
+				JobSystem_wait(self, dependency);
+				pthread_mutex_lock(&self->graph_lock);
+			}
+
+			if (atomic_load(&parent->generation) != dependency.generation) continue;
+
+			parent->dependents[parent->dependent_count++] = index;
+			atomic_fetch_add(&job->pending, 1);
+		}
+		pthread_mutex_unlock(&self->graph_lock);
+
+		if (atomic_fetch_sub(&job->pending, 1) == 1) pushJob(self, index);
+
+		return handle;
+	}
+#endif /* KOLIBRI_NO_THREADS */
+
+	(void)self;
+	function(data);
+
+	return JOB_NONE;
+}
+
+
+bool
+JobSystem_isComplete(JobSystem *self, JobHandle job)
+{
+#ifdef KOLIBRI_NO_THREADS
+	(void)self;
+	(void)job;
+	return true;
+#else
+	return job.index >= JOB_POOL_SIZE
+		|| atomic_load(&self->pool[job.index].generation) != job.generation;
+#endif
+}
+
+
+/* Runs other jobs while waiting, so it is safe to call from inside a job */
+void
+JobSystem_wait(JobSystem *self, JobHandle job)
+{
+#ifndef KOLIBRI_NO_THREADS
+	while (!JobSystem_isComplete(self, job)) {
+		if (!runOneJob(self)) sched_yield();
+	}
+#else
+	(void)self;
+	(void)job;
+#endif
+}
+
+
+void
+JobSystem_waitAll(JobSystem *self, const JobHandle *jobs, uint count)
+{
+	for (uint i = 0; i < count; i++) JobSystem_wait(self, jobs[i]);
+}
+
+
+/*
+	Calls function(data, start, end) over [0, count) in batches of batch_size,
+	spread across every thread, returning once all of them are done. A
+	batch_size of 0 picks one giving each thread a few batches. The caller
+	only ever runs batches of this loop, never other queued jobs.
+*/
+void
+JobSystem_parallelFor(
+	JobSystem        *self,
+	uint              count,
+	uint              batch_size,
+	JobRangeFunction  function,
+	void             *data
+)
+{
+	if (!count) return;
+
+#ifndef KOLIBRI_NO_THREADS
+	if (!batch_size) batch_size = MAX(1, count / (self->thread_count * 4));
+
+	uint batch_count = (count + batch_size - 1) / batch_size;
+
+	if (self->thread_count > 1 && batch_count > 1) {
+		ParallelFor range = {
+				.function   = function,
+				.data       = data,
+				.count      = count,
+				.batch_size = batch_size,
+			};
+		atomic_init(&range.next, 0);
+
+		uint      helper_count = self->thread_count - 1;
+		JobHandle helpers[JOB_MAX_THREADS];
+
+		if (helper_count > batch_count - 1) helper_count = batch_count - 1;
+
+		for (uint i = 0; i < helper_count; i++)
+			helpers[i] = JobSystem_submit(self, runParallelFor, &range, NULL, 0);
+
+		runParallelFor(&range);
+		for (uint i = 0; i < helper_count; i++) {
+			while (!JobSystem_isComplete(self, helpers[i])) {
+				if (!runOwnHelper(self, &range)) sched_yield();
+			}
+		}
+		return;
+	}
+#else
+	(void)self;
+	(void)batch_size;
+#endif /* !KOLIBRI_NO_THREADS */
+
+	function(data, 0, count);
+}
@@ -0,0 +1,368 @@
+#include <math.h>
+#include <raylib.h>
+#include <raymath.h>
+#include <string.h>
+
+#include "occlusion.h"
+
+
+/* View distance triangles are clipped at, and boxes reaching closer are never occluded */
+#define OCCLUSION_NEAR 0.1f
+/* Enough to bring any buffer down to a single texel */
+#define MAX_LEVELS     16
+
+
+struct
+OcclusionBuffer
+{
+	float *levels[MAX_LEVELS]; /* Level 0 is the depth buffer, each next one halves it */
+	uint
+	       widths[ MAX_LEVELS],
+	       heights[MAX_LEVELS],
+	       level_count;
+
+	/* The camera drawn from */
+	Vector3
+	       position,
+	       forward,
+	       right,
+	       up;
+	float
+	       scale_x,            /* View x over distance to buffer pixels */
+	       scale_y,
+	       half_width,
+	       half_height;
+	bool   orthographic;       /* Not supported; nothing is occluded */
+};
+
+/* x and y are view space until projected, w is the view distance */
+typedef struct
+{
+	float x, y, w;
+}
+ClipVertex;
+
+typedef struct
+{
+	float x, y, depth;
+}
+ScreenVertex;
+
+
+static inline ClipVertex
+toView(const OcclusionBuffer *buffer, Vector3 point)
+{
+	Vector3 offset = Vector3Subtract(point, buffer->position);
+	return (ClipVertex){
+			Vector3DotProduct(offset, buffer->right),
+			Vector3DotProduct(offset, buffer->up),
+			Vector3DotProduct(offset, buffer->forward),
+		};
+}
+
+static inline ScreenVertex
+project(const OcclusionBuffer *buffer, ClipVertex vertex)
+{
+	float depth = 1.0f / vertex.w;
+	return (ScreenVertex){
+			buffer->half_width  + vertex.x * depth * buffer->scale_x,
+			buffer->half_height - vertex.y * depth * buffer->scale_y,
+			depth,
+		};
+}
+
+static inline float
+edge(ScreenVertex a, ScreenVertex b, float x, float y)
+{
+	return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+/*
+	Half-space rasteriser sampling pixel centers. One over distance is
+	linear in screen space, so it interpolates with the barycentrics as is.
+*/
+static void
+rasterTriangle(OcclusionBuffer *buffer, ScreenVertex v0, ScreenVertex v1, ScreenVertex v2)
+{
+	float area = edge(v0, v1, v2.x, v2.y);
+	if (fabsf(area) < 1e-6f) return;
+	if (area < 0.0f) {
+		ScreenVertex swap = v1;
+		v1   = v2;
+		v2   = swap;
+		area = -area;
+	}
+
+	int
+		width  = buffer->widths[0],
+		height = buffer->heights[0],
+		min_x  = (int)fmaxf(floorf(fminf(v0.x, fminf(v1.x, v2.x))), 0.0f),
+		min_y  = (int)fmaxf(floorf(fminf(v0.y, fminf(v1.y, v2.y))), 0.0f),
+		max_x  = (int)fminf(ceilf( fmaxf(v0.x, fmaxf(v1.x, v2.x))), width  - 1),
+		max_y  = (int)fminf(ceilf( fmaxf(v0.y, fmaxf(v1.y, v2.y))), height - 1);
+	if (max_x < min_x || max_y < min_y) return;
+
+	float inv_area = 1.0f / area;
+	float *depths  = buffer->levels[0];
+
+	/* Step each edge function along the row instead of re-evaluating it */
+	float
+		step_0 = -(v2.y - v1.y),
+		step_1 = -(v0.y - v2.y),
+		step_2 = -(v1.y - v0.y);
+
+	for (int y = min_y; y <= max_y; y++) {
+		float
+			sample_x = min_x + 0.5f,
+			sample_y = y + 0.5f,
+			w0 = edge(v1, v2, sample_x, sample_y),
+			w1 = edge(v2, v0, sample_x, sample_y),
+			w2 = edge(v0, v1, sample_x, sample_y);
+		float *row = depths + y * width;
+
+		for (int x = min_x; x <= max_x; x++, w0 += step_0, w1 += step_1, w2 += step_2) {
+			if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+			float depth = (w0 * v0.depth + w1 * v1.depth + w2 * v2.depth) * inv_area;
+			if (row[x] < depth) row[x] = depth;
+		}
+	}
+}
+
+
+/*
+	Constructor/Destructor
+*/
+OcclusionBuffer *
+OcclusionBuffer_new(uint width, uint height)
+{
+	OcclusionBuffer *buffer = calloc(1, sizeof(OcclusionBuffer));
+	if (!buffer) {
+		ERR_OUT("Failed to allocate OcclusionBuffer.");
+		return NULL;
+	}
+
+	/* Every level, down to 1x1, in one block */
+	size_t total = 0;
+	for (uint w = width, h = height; buffer->level_count < MAX_LEVELS; w = (w + 1) / 2, h = (h + 1) / 2) {
+		buffer->widths[ buffer->level_count] = w;
+		buffer->heights[buffer->level_count] = h;
+		buffer->level_count++;
+		total += (size_t)w * h;
+		if (w == 1 && h == 1) break;
+	}
+
+	float *data = calloc(total, sizeof(float));
+	if (!data) {
+		ERR_OUT("Failed to allocate OcclusionBuffer depth.");
+		free(buffer);
+		return NULL;
+	}
+	for (uint i = 0; i < buffer->level_count; i++) {
+		buffer->levels[i] = data;
+		data += (size_t)buffer->widths[i] * buffer->heights[i];
+	}
+	buffer->half_width  = width  * 0.5f;
+	buffer->half_height = height * 0.5f;
+
+	return buffer;
+}
+
+void
+OcclusionBuffer_free(OcclusionBuffer *buffer)
+{
+	if (!buffer) return;
+
+	free(buffer->levels[0]);
+	free(buffer);
+}
+
+
+/*
+	Setters/Getters
+*/
+/* For debug views: level 0 is the rasterised depth, the rest are its hierarchy */
+const float *
+OcclusionBuffer_getDepth(OcclusionBuffer *buffer, uint level, uint *width, uint *height)
+{
+	if (buffer->level_count <= level) return NULL;
+
+	if (width)  *width  = buffer->widths[level];
+	if (height) *height = buffer->heights[level];
+	return buffer->levels[level];
+}
+
+
+/*
+	Methods
+*/
+/* Clear the buffer and draw from camera, whose view is aspect times wider than tall */
+void
+OcclusionBuffer_begin(OcclusionBuffer *buffer, const Camera3D *camera, float aspect)
+{
+	memset(buffer->levels[0], 0, (size_t)buffer->widths[0] * buffer->heights[0] * sizeof(float));
+
+	buffer->orthographic = (camera->projection != CAMERA_PERSPECTIVE);
+	buffer->position     = camera->position;
+	buffer->forward      = Vector3Normalize(Vector3Subtract(camera->target, camera->position));
+	buffer->right        = Vector3Normalize(Vector3CrossProduct(buffer->forward, camera->up));
+	buffer->up           = Vector3CrossProduct(buffer->right, buffer->forward);
+
+	float tan_half = tanf(camera->fovy * DEG2RAD * 0.5f);
+	buffer->scale_y = buffer->half_height / tan_half;
+	buffer->scale_x = buffer->half_width  / (tan_half * aspect);
+}
+
+void
+OcclusionBuffer_drawTriangle(OcclusionBuffer *buffer, Vector3 a, Vector3 b, Vector3 c)
+{
+	if (buffer->orthographic) return;
+
+	ClipVertex input[3] = { toView(buffer, a), toView(buffer, b), toView(buffer, c) };
+	ClipVertex clipped[4];
+	uint       count = 0;
+
+	/* Clip against the near plane, which leaves at most a quad */
+	for (uint i = 0; i < 3; i++) {
+		ClipVertex current = input[i],
+		           next    = input[(i + 1) % 3];
+		bool       current_in = OCCLUSION_NEAR <= current.w,
+		           next_in    = OCCLUSION_NEAR <= next.w;
+
+		if (current_in) clipped[count++] = current;
+		if (current_in != next_in) {
+			float t = (OCCLUSION_NEAR - current.w) / (next.w - current.w);
+			clipped[count++] = (ClipVertex){
+					current.x + (next.x - current.x) * t,
+					current.y + (next.y - current.y) * t,
+					OCCLUSION_NEAR,
+				};
+		}
+	}
+	if (count < 3) return;
+
+	ScreenVertex screen[4];
+	for (uint i = 0; i < count; i++) screen[i] = project(buffer, clipped[i]);
+
+	rasterTriangle(buffer, screen[0], screen[1], screen[2]);
+	if (count == 4) rasterTriangle(buffer, screen[0], screen[2], screen[3]);
+}
+
+void
+OcclusionBuffer_drawQuad(OcclusionBuffer *buffer, Vector3 a, Vector3 b, Vector3 c, Vector3 d)
+{
+	OcclusionBuffer_drawTriangle(buffer, a, b, c);
+	OcclusionBuffer_drawTriangle(buffer, a, c, d);
+}
+
+/* A solid box, e.g. a brush, by the faces toward the camera */
+void
+OcclusionBuffer_drawBox(OcclusionBuffer *buffer, Vector3 min, Vector3 max)
+{
+	Vector3 corners[8];
+	for (int i = 0; i < 8; i++) {
+		corners[i] = (Vector3){
+				(i & 1) ? max.x : min.x,
+				(i & 2) ? max.y : min.y,
+				(i & 4) ? max.z : min.z,
+			};
+	}
+
+	const Vector3 *c = corners;
+	if (buffer->position.x < min.x) OcclusionBuffer_drawQuad(buffer, c[0], c[2], c[6], c[4]);
+	if (max.x < buffer->position.x) OcclusionBuffer_drawQuad(buffer, c[1], c[3], c[7], c[5]);
+	if (buffer->position.y < min.y) OcclusionBuffer_drawQuad(buffer, c[0], c[1], c[5], c[4]);
+	if (max.y < buffer->position.y) OcclusionBuffer_drawQuad(buffer, c[2], c[3], c[7], c[6]);
+	if (buffer->position.z < min.z) OcclusionBuffer_drawQuad(buffer, c[0], c[1], c[3], c[2]);
+	if (max.z < buffer->position.z) OcclusionBuffer_drawQuad(buffer, c[4], c[5], c[7], c[6]);
+}
+
+/* Build the hierarchy: each texel keeps the farthest depth of the four below it */
+void
+OcclusionBuffer_finish(OcclusionBuffer *buffer)
+{
+	for (uint level = 1; level < buffer->level_count; level++) {
+		const float *below        = buffer->levels[level - 1];
+		float       *above        = buffer->levels[level];
+		uint         below_width  = buffer->widths[ level - 1],
+		             below_height = buffer->heights[level - 1];
+
+		for (uint y = 0; y < buffer->heights[level]; y++) {
+			uint y0 = y * 2,
+			     y1 = (y0 + 1 < below_height) ? y0 + 1 : y0;
+
+			for (uint x = 0; x < buffer->widths[level]; x++) {
+				uint x0 = x * 2,
+				     x1 = (x0 + 1 < below_width) ? x0 + 1 : x0;
+
+				above[y * buffer->widths[level] + x] = fminf(
+						fminf(below[y0 * below_width + x0], below[y0 * below_width + x1]),
+						fminf(below[y1 * below_width + x0], below[y1 * below_width + x1])
+					);
+			}
+		}
+	}
+}
+
+/*
+	True if the box from center - extents to center + extents is entirely
+	behind what has been drawn. Its nearest corner is compared against the
+	farthest occluder over its screen rectangle, read from the level where
+	that rectangle spans at most two texels each way.
+*/
+bool
+OcclusionBuffer_isBoxOccluded(OcclusionBuffer *buffer, Vector3 center, Vector3 extents)
+{
+	if (buffer->orthographic) return false;
+
+	float
+		min_x = INFINITY, min_y = INFINITY,
+		max_x = -INFINITY, max_y = -INFINITY,
+		nearest = 0.0f;
+
+	for (int i = 0; i < 8; i++) {
+		Vector3 corner = {
+				center.x + ((i & 1) ? extents.x : -extents.x),
+				center.y + ((i & 2) ? extents.y : -extents.y),
+				center.z + ((i & 4) ? extents.z : -extents.z),
+			};
+		ClipVertex view = toView(buffer, corner);
+		if (view.w < OCCLUSION_NEAR) return false;
+
+		ScreenVertex screen = project(buffer, view);
+		min_x   = fminf(min_x, screen.x);
+		min_y   = fminf(min_y, screen.y);
+		max_x   = fmaxf(max_x, screen.x);
+		max_y   = fmaxf(max_y, screen.y);
+		nearest = fmaxf(nearest, screen.depth);
+	}
+
+	int
+		width  = buffer->widths[0],
+		height = buffer->heights[0];
+
+	/* Off screen is for frustum culling to decide */
+	if (max_x < 0.0f || max_y < 0.0f || width <= min_x || height <= min_y) return false;
+
+	int
+		x0 = (int)fmaxf(min_x, 0.0f),
+		y0 = (int)fmaxf(min_y, 0.0f),
+		x1 = (int)fminf(max_x, width  - 1),
+		y1 = (int)fminf(max_y, height - 1);
+
+	uint level = 0;
+	while (level + 1 < buffer->level_count
+		&& (1 < (x1 >> level) - (x0 >> level) || 1 < (y1 >> level) - (y0 >> level))
+	) level++;
+
+	const float *depths = buffer->levels[level];
+	uint         stride = buffer->widths[level];
+
+	for (int y = y0 >> level; y <= y1 >> level; y++) {
+		for (int x = x0 >> level; x <= x1 >> level; x++) {
+			if (depths[y * stride + x] <= nearest) return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,459 @@
+#include <math.h>
+#include <raylib.h>
+#include <string.h>
+
+#include "octree.h"
+#include "dynamicarray.h"
+#include "frustum.h"
+
+
+/* Items from intersecting nodes are packed this many at a time for cullSpheresInFrustum() */
+#define QUERY_BATCH_SIZE 64
+
+/* An item's remembered result for a slot: the plane which rejected it, or */
+#define PLANE_PASSED 0x7F
+/* set on top of either once it has moved */
+#define PLANE_STALE  0x80
+
+
+typedef struct
+OctreeNode
+{
+	Vector3 center;
+	float   half_size;    /* Of the cell; items may reach twice as far */
+	uint32  parent;
+	uint32  children[8];  /* OCTREE_NONE until something lands there */
+	uint32  first_item;
+	uint    total_count;  /* Items in this node and below, to skip empty branches */
+	uint8   depth;
+}
+OctreeNode;
+
+typedef struct
+OctreeItem
+{
+	void   *data;
+	Vector3 center;
+	float   radius;
+	uint32
+	        node,         /* OCTREE_NONE while on the free list */
+	        prev,
+	        next;         /* Within the node, or the free list */
+	uint8   planes[OCTREE_QUERY_SLOTS]; /* Last result per slot; each only written by its own slot's queries */
+}
+OctreeItem;
+
+struct
+LooseOctree
+{
+	OctreeNode *nodes;    /* DynamicArray; the root is always first */
+	OctreeItem *items;    /* DynamicArray, indexed by handle */
+	uint32      free_items;
+	uint        count;
+	Plane       slot_frustums[OCTREE_QUERY_SLOTS][6]; /* As of each slot's last query */
+};
+
+
+/* Items from intersecting nodes, waiting to be tested together */
+typedef struct
+QueryBatch
+{
+	LooseOctree   *tree;
+	const Frustum *frustum;
+	uint32       **results;
+	int            slot;      /* -1 for none */
+	bool           unchanged; /* The frustum is the slot's last one */
+	uint           count;
+	uint32         handles[QUERY_BATCH_SIZE];
+	float
+	               x[QUERY_BATCH_SIZE],
+	               y[QUERY_BATCH_SIZE],
+	               z[QUERY_BATCH_SIZE],
+	               radius[QUERY_BATCH_SIZE];
+}
+QueryBatch;
+
+
+enum { OUTSIDE, INTERSECTING, INSIDE };
+
+
+static void
+resetRoot(LooseOctree *tree, Vector3 center, float half_size)
+{
+	OctreeNode root = {
+			.center     = center,
+			.half_size  = half_size,
+			.parent     = OCTREE_NONE,
+			.first_item = OCTREE_NONE,
+		};
+	for (int i = 0; i < 8; i++) root.children[i] = OCTREE_NONE;
+
+	DynamicArray_clear(tree->nodes);
+	DynamicArray_clear(tree->items);
+	DynamicArray_add(tree->nodes, root);
+	tree->free_items = OCTREE_NONE;
+	tree->count      = 0;
+}
+
+static inline bool
+isInCell(const OctreeNode *node, Vector3 center)
+{
+	return fabsf(center.x - node->center.x) <= node->half_size
+		&& fabsf(center.y - node->center.y) <= node->half_size
+		&& fabsf(center.z - node->center.z) <= node->half_size;
+}
+
+/* The smallest node whose loose bounds hold the sphere, creating it if need be */
+static uint32
+findNode(LooseOctree *tree, Vector3 center, float radius)
+{
+	uint32 index = 0;
+
+	if (!isInCell(&tree->nodes[0], center)) return 0;
+
+	for (;;) {
+		OctreeNode *node       = &tree->nodes[index];
+		float       child_half = node->half_size * 0.5f;
+
+		if (OCTREE_MAX_DEPTH <= node->depth || child_half < radius) return index;
+
+		uint octant = (node->center.x <= center.x)
+			| ((node->center.y <= center.y) << 1)
+			| ((node->center.z <= center.z) << 2);
+
+		if (node->children[octant] == OCTREE_NONE) {
+			OctreeNode child = {
+					.center     = {
+							node->center.x + ((octant & 1) ? child_half : -child_half),
+							node->center.y + ((octant & 2) ? child_half : -child_half),
+							node->center.z + ((octant & 4) ? child_half : -child_half),
+						},
+					.half_size  = child_half,
+					.parent     = index,
+					.first_item = OCTREE_NONE,
+					.depth      = node->depth + 1,
+				};
+			for (int i = 0; i < 8; i++) child.children[i] = OCTREE_NONE;
+
+			uint32 child_index = DynamicArray_length(tree->nodes);
+			DynamicArray_add(tree->nodes, child);
+			/* The add may have moved the nodes */
+			tree->nodes[index].children[octant] = child_index;
+		}
+		index = tree->nodes[index].children[octant];
+	}
+}
+
+static void
+linkItem(LooseOctree *tree, uint32 handle, uint32 index)
+{
+	OctreeItem *item = &tree->items[handle];
+	OctreeNode *node = &tree->nodes[index];
+
+	item->node = index;
+	item->prev = OCTREE_NONE;
+	item->next = node->first_item;
+	if (node->first_item != OCTREE_NONE) tree->items[node->first_item].prev = handle;
+	node->first_item = handle;
+
+	for (; index != OCTREE_NONE; index = tree->nodes[index].parent)
+		tree->nodes[index].total_count++;
+}
+
+static void
+unlinkItem(LooseOctree *tree, uint32 handle)
+{
+	OctreeItem *item  = &tree->items[handle];
+	uint32      index = item->node;
+
+	if (item->prev != OCTREE_NONE) tree->items[item->prev].next = item->next;
+	else tree->nodes[index].first_item = item->next;
+	if (item->next != OCTREE_NONE) tree->items[item->next].prev = item->prev;
+
+	for (; index != OCTREE_NONE; index = tree->nodes[index].parent)
+		tree->nodes[index].total_count--;
+}
+
+static int
+classifyBox(Vector3 center, float extent, const Frustum *frustum)
+{
+	int result = INSIDE;
+
+	for (int i = FRUSTUM_LEFT; i <= FRUSTUM_FAR; i++) {
+		const Plane *plane  = &frustum->planes[i];
+		float        radius = extent * (fabsf(plane->normal.x) + fabsf(plane->normal.y) + fabsf(plane->normal.z));
+		float        distance = plane->normal.x * center.x
+			+ plane->normal.y * center.y
+			+ plane->normal.z * center.z
+			+ plane->distance;
+
+		if (distance < -radius) return OUTSIDE;
+		if (distance < radius)  result = INTERSECTING;
+	}
+
+	return result;
+}
+
+static inline bool
+isBehindPlane(const Plane *plane, Vector3 center, float radius)
+{
+	return plane->normal.x * center.x
+		+ plane->normal.y * center.y
+		+ plane->normal.z * center.z
+		+ plane->distance < -radius;
+}
+
+static void
+flushBatch(QueryBatch *batch)
+{
+	uint32 visible[FRUSTUM_MASK_WORDS(QUERY_BATCH_SIZE)];
+
+	cullSpheresInFrustum(batch->frustum, batch->x, batch->y, batch->z, batch->radius, batch->count, visible);
+	for (uint i = 0; i < batch->count; i++) {
+		bool   passed = visible[i / 32] & (1u << (i % 32));
+		uint32 handle = batch->handles[i];
+
+		if (passed) DynamicArray_add(*batch->results, handle);
+		if (batch->slot < 0) continue;
+
+		/* Remember which plane rejected it, to try first next time */
+		uint8 plane = PLANE_PASSED;
+		if (!passed) {
+			Vector3 center = {batch->x[i], batch->y[i], batch->z[i]};
+			for (plane = FRUSTUM_LEFT; plane < FRUSTUM_FAR; plane++) {
+				if (isBehindPlane(&batch->frustum->planes[plane], center, batch->radius[i])) break;
+			}
+		}
+		batch->tree->items[handle].planes[batch->slot] = plane;
+	}
+	batch->count = 0;
+}
+
+static void
+queryNode(LooseOctree *tree, uint32 index, QueryBatch *batch, bool inside)
+{
+	const OctreeNode *node = &tree->nodes[index];
+	if (!node->total_count) return;
+
+	/* The root's items may lie anywhere, so only its children are classified */
+	if (!inside && index != 0) {
+		int side = classifyBox(node->center, node->half_size * 2.0f, batch->frustum);
+		if (side == OUTSIDE) return;
+		inside = (side == INSIDE);
+	}
+
+	for (uint32 handle = node->first_item; handle != OCTREE_NONE; handle = tree->items[handle].next) {
+		if (inside) {
+			DynamicArray_add(*batch->results, handle);
+			continue;
+		}
+
+		OctreeItem *item = &tree->items[handle];
+
+		if (0 <= batch->slot) {
+			uint8 plane = item->planes[batch->slot];
+
+			/* Neither it nor the frustum moved, so the answer can't have changed */
+			if (batch->unchanged && !(plane & PLANE_STALE)) {
+				if (plane == PLANE_PASSED) DynamicArray_add(*batch->results, handle);
+				continue;
+			}
+
+			/* Whatever rejected it last time most likely still does */
+			plane &= ~PLANE_STALE;
+			if (plane < PLANE_PASSED && isBehindPlane(&batch->frustum->planes[plane], item->center, item->radius)) {
+				item->planes[batch->slot] = plane;
+				continue;
+			}
+		}
+
+		batch->handles[batch->count] = handle;
+		batch->x[batch->count]       = item->center.x;
+		batch->y[batch->count]       = item->center.y;
+		batch->z[batch->count]       = item->center.z;
+		batch->radius[batch->count]  = item->radius;
+		if (++batch->count == QUERY_BATCH_SIZE) flushBatch(batch);
+	}
+
+	for (int i = 0; i < 8; i++) {
+		if (node->children[i] != OCTREE_NONE)
+			queryNode(tree, node->children[i], batch, inside);
+	}
+}
+
+
+/*
+	Constructor/Destructor
+*/
+LooseOctree *
+LooseOctree_new(Vector3 center, float half_size)
+{
+	LooseOctree *tree = calloc(1, sizeof(LooseOctree));
+	if (!tree) {
+		ERR_OUT("Failed to allocate LooseOctree.");
+		return NULL;
+	}
+
+	tree->nodes = DynamicArray(OctreeNode, 64);
+	tree->items = DynamicArray(OctreeItem, 512);
+	if (!tree->nodes || !tree->items) {
+		ERR_OUT("Failed to allocate LooseOctree storage.");
+		DynamicArray_free(tree->nodes);
+		DynamicArray_free(tree->items);
+		free(tree);
+		return NULL;
+	}
+	resetRoot(tree, center, half_size);
+
+	return tree;
+}
+
+void
+LooseOctree_free(LooseOctree *tree)
+{
+	if (!tree) return;
+
+	DynamicArray_free(tree->nodes);
+	DynamicArray_free(tree->items);
+	free(tree);
+}
+
+
+/*
+	Setters/Getters
+*/
+void *
+LooseOctree_getData(LooseOctree *tree, uint32 item)
+{
+	return tree->items[item].data;
+}
+
+uint
+LooseOctree_getCount(LooseOctree *tree)
+{
+	return tree->count;
+}
+
+
+/*
+	Methods
+*/
+void
+LooseOctree_clear(LooseOctree *tree)
+{
+	OctreeNode *root = &tree->nodes[0];
+	resetRoot(tree, root->center, root->half_size);
+}
+
+/* Returns a handle which stays valid until removed */
+uint32
+LooseOctree_insert(LooseOctree *tree, void *data, Vector3 center, float radius)
+{
+	uint32 handle = tree->free_items;
+
+	if (handle != OCTREE_NONE) {
+		tree->free_items = tree->items[handle].next;
+	}
+	else {
+		OctreeItem blank = {0};
+		handle = DynamicArray_length(tree->items);
+		DynamicArray_add(tree->items, blank);
+	}
+
+	tree->items[handle] = (OctreeItem){
+			.data   = data,
+			.center = center,
+			.radius = radius,
+		};
+	memset(tree->items[handle].planes, PLANE_STALE | PLANE_PASSED, sizeof(tree->items[handle].planes));
+	linkItem(tree, handle, findNode(tree, center, radius));
+	tree->count++;
+
+	return handle;
+}
+
+/* Cheap when the item hasn't left its node's loose bounds */
+void
+LooseOctree_update(LooseOctree *tree, uint32 handle, Vector3 center, float radius)
+{
+	OctreeItem *item = &tree->items[handle];
+
+	if (item->radius == radius
+		&& item->center.x == center.x
+		&& item->center.y == center.y
+		&& item->center.z == center.z
+	) return;
+
+	item->center = center;
+	item->radius = radius;
+	for (int i = 0; i < OCTREE_QUERY_SLOTS; i++) item->planes[i] |= PLANE_STALE;
+
+	const OctreeNode *node = &tree->nodes[item->node];
+	if (item->node == 0) {
+		/* Only sink out of the root if the item now fits lower down */
+		if (!isInCell(node, center) || node->half_size * 0.5f < radius) return;
+	}
+	else if (isInCell(node, center) && radius <= node->half_size) {
+		return;
+	}
+
+	unlinkItem(tree, handle);
+	linkItem(tree, handle, findNode(tree, center, radius));
+}
+
+void
+LooseOctree_remove(LooseOctree *tree, uint32 handle)
+{
+	unlinkItem(tree, handle);
+
+	OctreeItem *item = &tree->items[handle];
+	item->data = NULL;
+	item->node = OCTREE_NONE;
+	item->next = tree->free_items;
+	tree->free_items = handle;
+	tree->count--;
+}
+
+static uint
+query(LooseOctree *tree, const Frustum *frustum, int slot, uint32 **results)
+{
+	size_t     start = DynamicArray_length(*results);
+	QueryBatch batch = {
+			.tree    = tree,
+			.frustum = frustum,
+			.results = results,
+			.slot    = slot,
+		};
+
+	if (0 <= slot) {
+		batch.unchanged = !memcmp(tree->slot_frustums[slot], frustum->planes, sizeof(frustum->planes));
+		memcpy(tree->slot_frustums[slot], frustum->planes, sizeof(frustum->planes));
+	}
+
+	queryNode(tree, 0, &batch, false);
+	if (batch.count) flushBatch(&batch);
+
+	return DynamicArray_length(*results) - start;
+}
+
+/* Appends the handles of items touching frustum to the DynamicArray results */
+uint
+LooseOctree_queryFrustum(LooseOctree *tree, const Frustum *frustum, uint32 **results)
+{
+	return query(tree, frustum, -1, results);
+}
+
+/*
+	The same, for a viewer which queries the tree every frame. Each item
+	remembers its last result for slot: items rejected last time first try
+	the plane which rejected them, and if neither the frustum nor the item
+	has moved since, the last result is reused without testing at all.
+	Queries for different slots may run at once.
+*/
+uint
+LooseOctree_queryFrustumCoherent(LooseOctree *tree, const Frustum *frustum, uint slot, uint32 **results)
+{
+	if (OCTREE_QUERY_SLOTS <= slot) return query(tree, frustum, -1, results);
+
+	return query(tree, frustum, slot, results);
+}
@@ -0,0 +1,324 @@
+#include <string.h>
+#include <time.h>
+
+#include "profiler.h"
+
+
+#ifdef KOLIBRI_PROFILE
+
+#ifdef KOLIBRI_NO_THREADS
+	#define THREAD_LOCAL
+#else
+	#define THREAD_LOCAL _Thread_local
+#endif
+
+
+typedef struct
+ZoneRecord
+{
+	const char *name;        /* Claimed with a compare-and-swap */
+	uint64      frame_ns;    /* Time accumulated this frame, from any thread */
+	uint32      frame_calls;
+	uint32      last_calls;
+	float       history[PROFILER_HISTORY]; /* Milliseconds per frame */
+}
+ZoneRecord;
+
+typedef struct
+TraceEvent
+{
+	const char *name;
+	uint64
+	            start,
+	            end;
+}
+TraceEvent;
+
+/* Ring of the latest zones to end on one thread */
+typedef struct
+TraceBuffer
+{
+	uint64     count;
+	uint       thread_ID;
+	TraceEvent events[PROFILER_EVENT_BUFFER_SIZE];
+}
+TraceBuffer;
+
+
+static ZoneRecord                Zones[PROFILER_MAX_ZONES];
+static TraceBuffer              *Buffers[PROFILER_MAX_THREADS];
+static uint                      Buffer_count = 0;
+static uint64                    Frame_num    = 0;
+static uint64                    Epoch        = 0;
+static THREAD_LOCAL TraceBuffer *Thread_buffer = NULL;
+
+
+static inline uint64
+nowNs(void)
+{
+	struct timespec now;
+#if defined(__unix__) || defined(__APPLE__)
+	clock_gettime(CLOCK_MONOTONIC, &now);
+#else
+	timespec_get(&now, TIME_UTC);
+#endif
+	return (uint64)now.tv_sec * 1000000000ull + (uint64)now.tv_nsec;
+}
+
+/* FNV-1a, so the same name from different translation units shares a zone */
+static inline uint32
+hashName(const char *name)
+{
+	uint32 hash = 2166136261u;
+	while (*name) {
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static ZoneRecord *
+findZone(const char *name, bool insert)
+{
+	uint32 hash = hashName(name);
+
+	for (uint i = 0; i < PROFILER_MAX_ZONES; i++) {
+		ZoneRecord *zone     = &Zones[(hash + i) & (PROFILER_MAX_ZONES - 1)];
+		const char *existing = __atomic_load_n(&zone->name, __ATOMIC_ACQUIRE);
+
+		if (!existing) {
+			if (!insert) return NULL;
+			if (__atomic_compare_exchange_n(
+					&zone->name, &existing, name, false,
+					__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE
+				))
+				return zone;
+			/* Lost the race; existing now holds the winner */
+		}
+		if (existing == name || !strcmp(existing, name)) return zone;
+	}
+
+	return NULL;
+}
+
+static TraceBuffer *
+getThreadBuffer(void)
+{
+	if (Thread_buffer) return Thread_buffer;
+
+	uint index = __atomic_fetch_add(&Buffer_count, 1, __ATOMIC_RELAXED);
+	if (PROFILER_MAX_THREADS <= index) return NULL;
+
+	TraceBuffer *buffer = calloc(1, sizeof(TraceBuffer));
+	if (!buffer) {
+		ERR_OUT("Failed to allocate profiler trace buffer.");
+		return NULL;
+	}
+	buffer->thread_ID = index;
+	__atomic_store_n(&Buffers[index], buffer, __ATOMIC_RELEASE);
+
+	return Thread_buffer = buffer;
+}
+
+static void
+writeEscaped(FILE *file, const char *text)
+{
+	for (; *text; text++) {
+		if (*text == '"' || *text == '\\') fputc('\\', file);
+		if ((unsigned char)*text < 0x20) continue;
+		fputc(*text, file);
+	}
+}
+
+
+/**************
+	METHODS
+**************/
+ProfileZone
+Profiler_beginZone(const char *name)
+{
+	uint64 now = nowNs();
+
+	if (!__atomic_load_n(&Epoch, __ATOMIC_RELAXED)) {
+		uint64 unset = 0;
+		__atomic_compare_exchange_n(&Epoch, &unset, now, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	}
+
+	return (ProfileZone){name, now};
+}
+
+void
+Profiler_endZone(ProfileZone *zone)
+{
+	uint64      end    = nowNs();
+	ZoneRecord *record = findZone(zone->name, true);
+
+	if (record) {
+		__atomic_fetch_add(&record->frame_ns,    end - zone->start, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&record->frame_calls, 1,                 __ATOMIC_RELAXED);
+	}
+
+	TraceBuffer *buffer = getThreadBuffer();
+	if (!buffer) return;
+
+	buffer->events[buffer->count & (PROFILER_EVENT_BUFFER_SIZE - 1)] = (TraceEvent){
+			.name  = zone->name,
+			.start = zone->start,
+			.end   = end,
+		};
+	__atomic_store_n(&buffer->count, buffer->count + 1, __ATOMIC_RELEASE);
+}
+
+
+/* Close out the current frame's totals into each zone's history */
+void
+Profiler_frame(void)
+{
+	uint slot = Frame_num % PROFILER_HISTORY;
+
+	for (uint i = 0; i < PROFILER_MAX_ZONES; i++) {
+		ZoneRecord *zone = &Zones[i];
+		if (!__atomic_load_n(&zone->name, __ATOMIC_ACQUIRE)) continue;
+
+		uint64 ns = __atomic_exchange_n(&zone->frame_ns, 0, __ATOMIC_RELAXED);
+		zone->last_calls    = __atomic_exchange_n(&zone->frame_calls, 0, __ATOMIC_RELAXED);
+		zone->history[slot] = ns / 1000000.0f;
+	}
+	Frame_num++;
+}
+
+
+bool
+Profiler_getStats(const char *name, ProfileStats *stats)
+{
+	ZoneRecord *zone = findZone(name, false);
+	if (!zone) return false;
+
+	uint frames = (Frame_num < PROFILER_HISTORY) ? Frame_num : PROFILER_HISTORY;
+
+	*stats = (ProfileStats){
+			.name       = zone->name,
+			.min_ms     = frames ? zone->history[0] : 0.0f,
+			.last_calls = zone->last_calls,
+		};
+	if (!frames) return true;
+
+	float total = 0.0f;
+	for (uint i = 0; i < frames; i++) {
+		float ms = zone->history[i];
+		total += ms;
+		if (ms < stats->min_ms) stats->min_ms = ms;
+		if (stats->max_ms < ms) stats->max_ms = ms;
+	}
+	stats->avg_ms  = total / frames;
+	stats->last_ms = zone->history[(Frame_num - 1) % PROFILER_HISTORY];
+
+	return true;
+}
+
+/* Fills stats with up to max_count zones, returning how many it filled */
+uint
+Profiler_getAllStats(ProfileStats *stats, uint max_count)
+{
+	uint count = 0;
+
+	for (uint i = 0; i < PROFILER_MAX_ZONES && count < max_count; i++) {
+		const char *name = __atomic_load_n(&Zones[i].name, __ATOMIC_ACQUIRE);
+		if (name && Profiler_getStats(name, &stats[count])) count++;
+	}
+
+	return count;
+}
+
+
+/*
+	Write the zone events still in every thread's ring as Chrome trace-event
+	JSON, for chrome://tracing or Perfetto. Call between frames, when no
+	zones are being recorded.
+*/
+bool
+Profiler_dumpTrace(const char *path)
+{
+	FILE *file = fopen(path, "w");
+	if (!file) {
+		ERR_OUT("Failed to open profiler trace file.");
+		return false;
+	}
+
+	uint buffer_count = __atomic_load_n(&Buffer_count, __ATOMIC_RELAXED);
+	bool first        = true;
+
+	if (PROFILER_MAX_THREADS < buffer_count) buffer_count = PROFILER_MAX_THREADS;
+
+	fputs("{\"traceEvents\":[\n", file);
+	for (uint i = 0; i < buffer_count; i++) {
+		TraceBuffer *buffer = __atomic_load_n(&Buffers[i], __ATOMIC_ACQUIRE);
+		if (!buffer) continue;
+
+		uint64 count = __atomic_load_n(&buffer->count, __ATOMIC_ACQUIRE);
+		uint64 start = (PROFILER_EVENT_BUFFER_SIZE < count) ? count - PROFILER_EVENT_BUFFER_SIZE : 0;
+
+		for (uint64 e = start; e < count; e++) {
+			TraceEvent *event = &buffer->events[e & (PROFILER_EVENT_BUFFER_SIZE - 1)];
+
+			fputs(first ? "{\"name\":\"" : ",\n{\"name\":\"", file);
+			writeEscaped(file, event->name);
+			fprintf(
+					file,
+					"\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					buffer->thread_ID,
+					(event->start - Epoch) / 1000.0,
+					(event->end - event->start) / 1000.0
+				);
+			first = false;
+		}
+	}
+	fputs("\n]}\n", file);
+
+	return fclose(file) == 0;
+}
+
+#else /* !KOLIBRI_PROFILE */
+
+/* Profiling compiled out: keep the symbols so callers needn't care */
+ProfileZone
+Profiler_beginZone(const char *name)
+{
+	return (ProfileZone){name, 0};
+}
+
+void
+Profiler_endZone(ProfileZone *zone)
+{
+	(void)zone;
+}
+
+void
+Profiler_frame(void)
+{
+}
+
+bool
+Profiler_getStats(const char *name, ProfileStats *stats)
+{
+	(void)name;
+	(void)stats;
+	return false;
+}
+
+uint
+Profiler_getAllStats(ProfileStats *stats, uint max_count)
+{
+	(void)stats;
+	(void)max_count;
+	return 0;
+}
+
+bool
+Profiler_dumpTrace(const char *path)
+{
+	(void)path;
+	return false;
+}
+
+#endif /* KOLIBRI_PROFILE */
@@ -1,11 +1,17 @@
+#include "_engine_.h"
+#include "_entity_.h"
 #include "_head_.h"
 #include "_renderer_.h"
-#include "_spatialhash_.h"
 #include "dynamicarray.h"
+#include "jobs.h"
+#include "occlusion.h"
+#include "octree.h"
+#include "profiler.h"
 #include "scene.h"
 /* THIS MUST NECESSARILY COME AFTER ANY <raylib.h> */
 #include <raylib.h>
 #include <raymath.h>
+#include <string.h>
 
 
 typedef struct
@@ -17,28 +23,89 @@ typedef struct
     Vector3 
             position,
             bounds;
-    bool    is_entity;
+    /* Entities' are copied when submitted, since pipelined ticks may be changing them */
+    const EntityArchetype *archetype;
+    Vector3                renderable_offset;
+    float                  visibility_radius;
+    bool
+            is_entity,
+            visible;
 }
 RenderableWrapper;
 
+/* A wrapper one Head will draw, with what it settled on while culling */
+typedef struct
+VisibleItem
+{
+	Renderable *selected; /* LOD chosen for this Head */
+	float       dist_sq;  /* To this Head's camera */
+	uint32      wrapper;  /* Into wrapper_pool, which may move while submitting */
+}
+VisibleItem;
+
+/* A queued draw, and what it sorts by */
+typedef struct
+DrawKey
+{
+	uint64 key;   /* Opaque: render state, then depth. Transparent: depth only */
+	uint32 item;  /* Into the HeadView's visible items */
+}
+DrawKey;
+
+/* A submission the culling octree remembers between frames, by octree handle */
+typedef struct
+CullItem
+{
+	const void *key;        /* The Entity or Renderable submitted, NULL if unused */
+	uint32      occurrence; /* Among one pass's submissions of the same key */
+	uint32      wrapper;    /* Into wrapper_pool, for the pass it was last seen in */
+	uint64
+	            pass,
+	            frame;
+}
+CullItem;
+
+/* What one Head sees of the frame's shared submissions */
+typedef struct
+HeadView
+{
+	uint32          *candidates; /* Octree handles, DynamicArray */
+	VisibleItem     *visible;    /* DynamicArray */
+	OcclusionBuffer *occlusion;  /* Made the first time this Head occlusion culls */
+	uint             occluded;   /* Wrappers it hid this frame */
+	float            lod_scale;  /* Screen-space LOD's distance divisor, 0 if unused */
+	bool
+	                 culled,     /* By Renderer__cull(), and not yet drawn */
+	                 occluding;  /* occlusion holds this frame's occluders */
+}
+HeadView;
+
 typedef struct
 Renderer
 {
-	SpatialHash *visibility_hash;
 	Engine      *engine;
 	bool         dirty;
 
-	RenderableWrapper  *wrapper_pool;
-    RenderableWrapper **all_wrappers;
-	RenderableWrapper **transparent_renderables;
-	void              **transparent_render_data; 
-	float              *transparent_distances;
+	LooseOctree *cull_tree;
+	CullItem    *cull_items;      /* DynamicArray indexed by octree handle */
+	uint32      *cull_slots;      /* Open addressed (key, occurrence) to handle */
+	uint32       cull_slot_count; /* Power of two */
+	uint64
+	             pass,            /* Bumped for every batch of submissions */
+	             shared_pass,     /* The one from Renderer__submit() */
+	             swept_frame;
+	size_t       shared_count;    /* Wrappers from Renderer__submit(), ahead of any Head's own */
+	HeadView     views[MAX_NUM_HEADS];
+
+	RenderableWrapper *wrapper_pool;
+	DrawKey           *transparent_keys;
+	DrawKey           *draw_keys;
+	DrawKey           *draw_scratch;          /* Radix sort ping-pong buffer */
+	Matrix            *instance_transforms;
 }
 Renderer;
 
 
-static void Renderer__sortTransparent(Renderer *renderer);
-
 
 /*
 	Constructor/Destructor
@@ -46,7 +113,7 @@ static void Renderer__sortTransparent(Renderer *renderer);
 Renderer *
 Renderer__new(Engine *engine)
 {
-	Renderer *renderer = malloc(sizeof(Renderer));
+	Renderer *renderer = calloc(1, sizeof(Renderer));
 
 	if (!renderer) {
 		ERR_OUT("Failed to allocate memory for Renderer.");
@@ -54,28 +121,41 @@ Renderer__new(Engine *engine)
 	}
 
 	renderer->engine            = engine;
-	renderer->visibility_hash   = SpatialHash_new();
 	renderer->dirty             = true;
 
-    renderer->wrapper_pool            = DynamicArray(RenderableWrapper,  512);
-    renderer->all_wrappers            = DynamicArray(RenderableWrapper*, 512);
-	renderer->transparent_renderables = DynamicArray(RenderableWrapper*, 256);
-	renderer->transparent_render_data = DynamicArray(void*,              256);
-	renderer->transparent_distances   = DynamicArray(float,              256);
+	renderer->cull_tree       = LooseOctree_new(V3_ZERO, CULL_OCTREE_SIZE);
+	renderer->cull_items      = DynamicArray(CullItem, 512);
+	renderer->cull_slot_count = 1024;
+	renderer->cull_slots      = malloc(renderer->cull_slot_count * sizeof(uint32));
+	renderer->swept_frame     = UINT64_MAX;
+	if (renderer->cull_slots)
+		memset(renderer->cull_slots, 0xFF, renderer->cull_slot_count * sizeof(uint32));
+
+	bool views_ok = true;
+	for (int i = 0; i < MAX_NUM_HEADS; i++) {
+		renderer->views[i].candidates = DynamicArray(uint32,      512);
+		renderer->views[i].visible    = DynamicArray(VisibleItem, 512);
+		views_ok = views_ok && renderer->views[i].candidates && renderer->views[i].visible;
+	}
+
+    renderer->wrapper_pool          = DynamicArray(RenderableWrapper, 512);
+	renderer->transparent_keys      = DynamicArray(DrawKey,           256);
+	renderer->draw_keys             = DynamicArray(DrawKey,           512);
+	renderer->draw_scratch          = DynamicArray(DrawKey,           512);
+	renderer->instance_transforms   = DynamicArray(Matrix,            256);
     
-	if (!renderer->transparent_renderables 
-        || !renderer->transparent_distances
-        || !renderer->transparent_render_data 
+	if (!renderer->transparent_keys
+        || !renderer->draw_keys
+        || !renderer->draw_scratch
+        || !renderer->instance_transforms
         || !renderer->wrapper_pool
+        || !renderer->cull_tree
+        || !renderer->cull_items
+        || !renderer->cull_slots
+        || !views_ok
 	) {
-	    ERR_OUT("Failed to allocate memory for transparent rendering.");
-	    SpatialHash_free( renderer->visibility_hash);
-	    DynamicArray_free(renderer->wrapper_pool);
-        DynamicArray_free(renderer->all_wrappers); 
-	    DynamicArray_free(renderer->transparent_renderables);
-	    DynamicArray_free(renderer->transparent_render_data);
-	    DynamicArray_free(renderer->transparent_distances);
-	    free(renderer);
+	    ERR_OUT("Failed to allocate memory for Renderer.");
+	    Renderer__free(renderer);
 	    return NULL;
 	}
     
@@ -86,12 +166,19 @@ Renderer__new(Engine *engine)
 void
 Renderer__free(Renderer *renderer)
 {
-	SpatialHash_free(renderer->visibility_hash);
-	DynamicArray_free(renderer->wrapper_pool);
-    DynamicArray_free(renderer->all_wrappers);
-    DynamicArray_free(renderer->transparent_renderables);
-	DynamicArray_free(renderer->transparent_render_data);
-    DynamicArray_free(renderer->transparent_distances);
+	LooseOctree_free(renderer->cull_tree);
+	free(renderer->cull_slots);
+	if (renderer->cull_items) DynamicArray_free(renderer->cull_items);
+	for (int i = 0; i < MAX_NUM_HEADS; i++) {
+		if (renderer->views[i].candidates) DynamicArray_free(renderer->views[i].candidates);
+		if (renderer->views[i].visible)    DynamicArray_free(renderer->views[i].visible);
+		OcclusionBuffer_free(renderer->views[i].occlusion);
+	}
+	if (renderer->wrapper_pool)          DynamicArray_free(renderer->wrapper_pool);
+	if (renderer->transparent_keys)      DynamicArray_free(renderer->transparent_keys);
+	if (renderer->draw_keys)             DynamicArray_free(renderer->draw_keys);
+	if (renderer->draw_scratch)          DynamicArray_free(renderer->draw_scratch);
+	if (renderer->instance_transforms)   DynamicArray_free(renderer->instance_transforms);
 	free(renderer);
 }
 
@@ -99,328 +186,636 @@ Renderer__free(Renderer *renderer)
 /*
 	Protected Methods
 */
-static inline bool
-isSphereBehindPlane(const Plane *plane, Vector3 center, float radius)
+/*
+	How much nearer than the reference view of LOD_REFERENCE_HEIGHT and
+	LOD_REFERENCE_FOVY head's view makes things look, over its pixel error
+	tolerance. Dividing a distance by it gives the one at which the
+	reference view sees an error as large as head does, so LOD distances
+	tuned there hold here. 0 when head picks LODs by distance alone.
+*/
+static float
+getLODScale(Head *head)
 {
-	float distance = Vector3DotProduct(plane->normal, center) + plane->distance;
-	return distance < -radius;
-}
+    Camera3D *camera = Head_getCamera(head);
+    float     error  = head->settings.lod_pixel_error;
 
-bool
-isSphereInFrustum(
-	Vector3  center, 
-	float    radius, 
-	Frustum *frustum
-)
-{ 
-    /* Test against frustum planes efficiently */
-    for (int i = FRUSTUM_LEFT; i <= FRUSTUM_FAR; i++) {
-        const Plane *plane = &frustum->planes[i];
-        float distance = Vector3DotProduct(plane->normal, center) + plane->distance;
-        if (distance < -radius) {
-            return false;
-        }
-    }
+    if (!head->settings.level_of_detail || error <= 0.0f) return 0.0f;
+    if (camera->projection != CAMERA_PERSPECTIVE || head->region.height <= 0) return 0.0f;
 
-    return true;
+    /* Pixels a unit of error spans one unit away */
+    float pixels           = head->region.height / (2.0f * tanf(camera->fovy * 0.5f * DEG2RAD));
+    float reference_pixels = LOD_REFERENCE_HEIGHT / (2.0f * tanf(LOD_REFERENCE_FOVY * 0.5f * DEG2RAD));
+
+    return pixels / (reference_pixels * error);
 }
 
-bool
-isAABBInFrustum(
-    Vector3  center,
-    Vector3  extents,
-    Frustum *frustum,
-    float    dist_sq,
-    float    max_distance
-)
+/* Settle which renderable a visible wrapper draws with, or NULL for none */
+static inline Renderable *
+selectRenderable(const RenderableWrapper *wrapper, Head *head, const HeadView *view, float dist_sq)
 {
-    /* Quick distance check first (using squared distance) */
-    float max_dist_check = max_distance + Vector3Length(extents);
-    if (dist_sq > max_dist_check * max_dist_check) {
-        return false;
-    }
+    if (!wrapper->is_entity) return wrapper->renderable;
     
-    /* Test against each frustum plane */
-    for (int i = FRUSTUM_LEFT; i <= FRUSTUM_FAR; i++) {
-        const Plane *plane = &frustum->planes[i];
-        
-        /* Calculate the effective radius of the box along the plane normal */
-        float radius = fabsf(extents.x * plane->normal.x)
-            + fabsf(extents.y * plane->normal.y)
-            + fabsf(extents.z * plane->normal.z);
-        
-        /* Distance from center to plane */
-        float distance = Vector3DotProduct(plane->normal, center) + plane->distance;
-        
-        /* If center is further than radius behind plane, box is completely outside */
-        if (distance < -radius) {
-            return false;
-        }
+    /* Errors are measured at the near side of the Entity, where they look biggest */
+    if (0.0f < view->lod_scale) {
+        float distance = fmaxf(sqrtf(dist_sq) - wrapper->visibility_radius, 0.0f) / view->lod_scale;
+        dist_sq = distance * distance;
     }
+    int lod = Entity__selectLOD(wrapper->entity, wrapper->archetype, head->index, dist_sq);
     
-    return true;
+    return (0 <= lod) ? wrapper->archetype->renderables[lod] : NULL;
 }
 
 
-/* Query for entities visible in camera frustum */
-RenderableWrapper **
-Renderer__queryFrustum(
-	Renderer *renderer,
-	Head     *head,
-	float     max_distance,
-	size_t   *visible_count
-)
+/* The sphere a wrapper is culled by */
+static inline Vector3
+getCullSphere(const RenderableWrapper *wrapper, float *radius)
 {
-    static RenderableWrapper *frustum_results[VIS_QUERY_SIZE];
-    *visible_count = 0;
-
-    if (!head) return frustum_results;
-    
-    Camera3D *camera = Head_getCamera(head);
-    Frustum  *frustum = Head_getFrustum(head);
-    
-    /* Pre-calculate values used in loop */
-    Vector3 camera_pos = camera->position;
-    float max_dist_sq = max_distance * max_distance;
-    
-    /* Get spatial hash candidates */
-    Vector3 forward = Vector3Normalize(
-            Vector3Subtract(
-                    camera->target, 
-                    camera_pos
-                )
-        );
-    Vector3 frustum_center = Vector3Add(camera_pos, Vector3Scale(forward, max_distance * 0.5f));
-    float query_radius = max_distance * 0.5f;
-    
-    Vector3 min_bounds = {
-        frustum_center.x - query_radius,
-        frustum_center.y - query_radius,
-        frustum_center.z - query_radius
-    };
-    Vector3 max_bounds = {
-        frustum_center.x + query_radius,
-        frustum_center.y + query_radius,
-        frustum_center.z + query_radius
-    };
-    
-    RenderableWrapper **candidates = (RenderableWrapper**)SpatialHash_queryRegion(
-        renderer->visibility_hash,
-        (BoundingBox){min_bounds, max_bounds}
-    );
-
-    /* Optimized culling loop */
-    for (int i = 0; i < DynamicArray_length(candidates) && *visible_count < VIS_QUERY_SIZE; i++) {
-        RenderableWrapper *wrapper = candidates[i];
-        
-        if (wrapper->is_entity && !wrapper->entity->visible) continue;
-        
-        /* Single distance calculation */
-        float dist_sq = Vector3DistanceSqr(wrapper->position, camera_pos);
-        if (dist_sq > max_dist_sq) continue;
-        
-        /* Fast frustum test with pre-calculated distance */
-        if (isSphereInFrustum(
-                wrapper->position,
-                wrapper->is_entity 
-                    ?  wrapper->entity->visibility_radius 
-                    : wrapper->bounds.x,
-                frustum
-            )) {
-            frustum_results[*visible_count] = wrapper;
-            (*visible_count)++;
-        }
+    if (!wrapper->is_entity) {
+        *radius = wrapper->bounds.x;
+        return wrapper->position;
     }
-    
-	DynamicArray_free(candidates);
-    return frustum_results;
+
+    *radius = wrapper->visibility_radius;
+    return wrapper->archetype
+        ? Vector3Add(wrapper->position, wrapper->renderable_offset)
+        : wrapper->position;
 }
 
 
-void
-Renderer__render(Renderer *renderer, Head *head)
+static inline uint32
+hashCullKey(const void *key, uint32 occurrence)
 {
-	RendererSettings *settings   = &head->settings;
-	Camera3D         *camera     = Head_getCamera(head);
-	Vector3           camera_pos = camera->position;
-	Scene            *scene      = Engine_getScene(renderer->engine);
-
-    /* Clear everything */
-    DynamicArray_clear(renderer->wrapper_pool);
-    DynamicArray_clear(renderer->all_wrappers); 
-    DynamicArray_clear(renderer->transparent_renderables);
-    DynamicArray_clear(renderer->transparent_render_data);
-	DynamicArray_clear(renderer->transparent_distances);
-	SpatialHash_clear( renderer->visibility_hash);
-
-	/* Step 1: Let scene submit all entities and geometry */
-    if (scene) {
-        Scene_render(scene, head);
+    uint64 hash = ((uint64)(uintptr_t)key >> 3) ^ ((uint64)occurrence << 48);
+    return (uint32)((hash * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+static uint32
+findCullItem(Renderer *renderer, const void *key, uint32 occurrence)
+{
+    uint32 mask = renderer->cull_slot_count - 1;
+
+    for (uint32 slot = hashCullKey(key, occurrence) & mask;; slot = (slot + 1) & mask) {
+        uint32 handle = renderer->cull_slots[slot];
+        if (handle == OCTREE_NONE) return OCTREE_NONE;
+
+        CullItem *item = &renderer->cull_items[handle];
+        if (item->key == key && item->occurrence == occurrence) return handle;
     }
+}
 
-    /* Step 2: Insert stable pointers into spatial hash */
-    size_t              wrapper_count    = DynamicArray_length(renderer->wrapper_pool);
-	size_t              visible_count    = 0;
-	RenderableWrapper **visible_wrappers = NULL;
-
-    if (settings->frustum_culling) {
-        for (size_t i = 0; i < wrapper_count; i++) {
-            RenderableWrapper *wrapper       = &renderer->wrapper_pool[i];
-            Vector3            render_center = wrapper->position;
-
-            if (wrapper->is_entity && 0 < wrapper->entity->lod_count) {
-                render_center = Vector3Add(
-                        wrapper->position,
-                        wrapper->entity->renderable_offset
-                    );
-            }
+static void
+placeCullSlot(Renderer *renderer, uint32 handle)
+{
+    CullItem *item = &renderer->cull_items[handle];
+    uint32    mask = renderer->cull_slot_count - 1;
+    uint32    slot = hashCullKey(item->key, item->occurrence) & mask;
+
+    while (renderer->cull_slots[slot] != OCTREE_NONE) slot = (slot + 1) & mask;
+    renderer->cull_slots[slot] = handle;
+}
+
+/* Backward-shift deletion, so lookups never need tombstones */
+static void
+removeCullSlot(Renderer *renderer, uint32 handle)
+{
+    CullItem *item = &renderer->cull_items[handle];
+    uint32    mask = renderer->cull_slot_count - 1;
+    uint32    hole = hashCullKey(item->key, item->occurrence) & mask;
+
+    while (renderer->cull_slots[hole] != handle) hole = (hole + 1) & mask;
+
+    for (uint32 slot = (hole + 1) & mask; renderer->cull_slots[slot] != OCTREE_NONE; slot = (slot + 1) & mask) {
+        CullItem *moved = &renderer->cull_items[renderer->cull_slots[slot]];
+        uint32    home  = hashCullKey(moved->key, moved->occurrence) & mask;
 
-            SpatialHash_insert(
-                    renderer->visibility_hash,
-                    wrapper,
-                    render_center,
-                    wrapper->bounds
-                );
+        if (((slot - hole) & mask) <= ((slot - home) & mask)) {
+            renderer->cull_slots[hole] = renderer->cull_slots[slot];
+            hole = slot;
         }
-    
-        /* Get items visible in frustum */
-        visible_wrappers = Renderer__queryFrustum(
-                renderer,
-                head, 
-                settings->max_render_distance, 
-                &visible_count
-            );
     }
-    else {
-        /* Build pointer array for all wrappers */
-        for (size_t i = 0; i < wrapper_count; i++) {
-            RenderableWrapper *wrapper = &renderer->wrapper_pool[i];
-            DynamicArray_add(renderer->all_wrappers, wrapper);
-        }
-        visible_wrappers = renderer->all_wrappers;
-        visible_count    = DynamicArray_length(renderer->wrapper_pool);
+    renderer->cull_slots[hole] = OCTREE_NONE;
+}
+
+static bool
+growCullSlots(Renderer *renderer)
+{
+    uint32  count = renderer->cull_slot_count * 2;
+    uint32 *slots = malloc(count * sizeof(uint32));
+
+    if (!slots) {
+        ERR_OUT("Failed to grow Renderer cull table.");
+        return false;
     }
-    
-    /* PASS 1: Render opaque stuff, collect transparent */
-    for (size_t i = 0; i < visible_count; i++) {
-        RenderableWrapper *wrapper = visible_wrappers[i];
-        
-        if (wrapper->is_entity && !wrapper->entity->visible) continue;
+    memset(slots, 0xFF, count * sizeof(uint32));
+    free(renderer->cull_slots);
+    renderer->cull_slots      = slots;
+    renderer->cull_slot_count = count;
+
+    for (uint32 handle = 0; handle < DynamicArray_length(renderer->cull_items); handle++) {
+        if (renderer->cull_items[handle].key) placeCullSlot(renderer, handle);
+    }
+
+    return true;
+}
+
+/*
+	Match the wrappers from first to last to the items the octree already
+	holds, so only the ones which moved out of their nodes get relinked, and
+	drop the ones nothing has submitted since last frame. Returns the pass
+	they were stamped with.
+*/
+static uint64
+updateCullItems(Renderer *renderer, size_t first, size_t last, bool shared)
+{
+    PROFILE_ZONE("Cull update");
+    uint64 frame = Engine_getFrameNumber(renderer->engine);
+    uint64 pass  = ++renderer->pass;
+
+    if (shared) renderer->shared_pass = pass;
 
-        Renderable *renderable  = NULL;
-        void       *render_data = NULL;
-        Vector3     render_pos  = wrapper->position;
+    if (renderer->swept_frame != frame) {
+        renderer->swept_frame = frame;
 
-        if (wrapper->is_entity) {
-            Entity *entity = wrapper->entity;
-            renderable     = Entity_getLODRenderable(entity, render_pos, camera_pos);
-            render_data    = entity;
+        for (uint32 handle = 0; handle < DynamicArray_length(renderer->cull_items); handle++) {
+            CullItem *item = &renderer->cull_items[handle];
+            if (!item->key || frame <= item->frame + 1) continue;
+
+            removeCullSlot(renderer, handle);
+            LooseOctree_remove(renderer->cull_tree, handle);
+            item->key = NULL;
+        }
+    }
+
+    for (size_t i = first; i < last; i++) {
+        RenderableWrapper *wrapper = &renderer->wrapper_pool[i];
+        const void        *key     = wrapper->is_entity ? (void*)wrapper->entity : (void*)wrapper->renderable;
+        float              radius;
+        Vector3            center  = getCullSphere(wrapper, &radius);
+
+        /*
+            The same key may be submitted several times a pass, e.g. wrapped
+            copies, and items from this frame's shared pass aren't a Head's to take
+        */
+        uint32 occurrence = 0;
+        uint32 handle;
+        while ((handle = findCullItem(renderer, key, occurrence)) != OCTREE_NONE
+            && (renderer->cull_items[handle].pass == pass
+                || renderer->cull_items[handle].pass == renderer->shared_pass)
+        ) occurrence++;
+
+        if (handle == OCTREE_NONE) {
+            uint count = LooseOctree_getCount(renderer->cull_tree);
+            if (renderer->cull_slot_count <= (count + 1) * 2 && !growCullSlots(renderer)) continue;
+
+            handle = LooseOctree_insert(renderer->cull_tree, NULL, center, radius);
+            while (DynamicArray_length(renderer->cull_items) <= handle) {
+                CullItem blank = {0};
+                DynamicArray_add(renderer->cull_items, blank);
+            }
+            renderer->cull_items[handle] = (CullItem){ .key = key, .occurrence = occurrence };
+            placeCullSlot(renderer, handle);
         }
         else {
-            renderable  = wrapper->renderable;
-            render_data = renderable->data;
+            LooseOctree_update(renderer->cull_tree, handle, center, radius);
         }
-        
-        if (!renderable) continue;
 
-        if (renderable->transparent) {
-            float dist = Vector3Distance(render_pos, camera_pos);
-            DynamicArray_add(renderer->transparent_renderables, wrapper);
-            DynamicArray_add(renderer->transparent_distances,   dist);
-            DynamicArray_add(renderer->transparent_render_data, render_data);  
+        CullItem *item = &renderer->cull_items[handle];
+        item->pass    = pass;
+        item->frame   = frame;
+        item->wrapper = i;
+    }
+
+    return pass;
+}
+
+
+static inline void
+addVisible(HeadView *view, const RenderableWrapper *wrapper, uint32 index, Head *head, float dist_sq)
+{
+    if (wrapper->is_entity && !wrapper->visible) return;
+
+    /* LOD is picked here, once, so the draw passes don't redo it */
+    VisibleItem item = {
+            .selected = selectRenderable(wrapper, head, view, dist_sq),
+            .dist_sq  = dist_sq,
+            .wrapper  = index,
+        };
+    if (!item.selected) return;
+
+    if (view->occluding) {
+        float   radius;
+        Vector3 center = getCullSphere(wrapper, &radius);
+
+        if (OcclusionBuffer_isBoxOccluded(view->occlusion, center, (Vector3){radius, radius, radius})) {
+            view->occluded++;
+            return;
         }
-        else if (renderable->Render) {
-            renderable->Render(renderable, render_data, render_pos, camera);
+    }
+    DynamicArray_add(view->visible, item);
+}
+
+/*
+	Append what head can see of the wrappers from first to last onto its
+	view. With frustum culling, those are found through the octree, and
+	must be the ones stamped with pass. Touches nothing but the view and
+	the Entities' LOD choices for this Head, so Heads can cull in parallel.
+*/
+static void
+cullView(Renderer *renderer, Head *head, HeadView *view, uint64 pass, size_t first, size_t last)
+{
+    RendererSettings *settings    = &head->settings;
+    Vector3           camera_pos  = Head_getCamera(head)->position;
+    float             max_dist_sq = settings->max_render_distance * settings->max_render_distance;
+
+    if (!settings->frustum_culling) {
+        for (size_t i = first; i < last; i++) {
+            RenderableWrapper *wrapper = &renderer->wrapper_pool[i];
+            addVisible(view, wrapper, i, head, Vector3DistanceSqr(wrapper->position, camera_pos));
         }
-	}
+        return;
+    }
 
-	/* PASS 2: Sort and render transparent */
-	size_t transparent_count = DynamicArray_length(renderer->transparent_renderables);
-	if (transparent_count <= 0) return;
+    /* Whole octree nodes inside the frustum come back without per-item tests */
+    DynamicArray_clear(view->candidates);
+    size_t candidate_count = LooseOctree_queryFrustumCoherent(
+            renderer->cull_tree,
+            Head_getFrustum(head),
+            head->index,
+            &view->candidates
+        );
 
-    Renderer__sortTransparent(renderer);
+    for (size_t i = 0; i < candidate_count; i++) {
+        const CullItem *item = &renderer->cull_items[view->candidates[i]];
+        if (item->pass != pass) continue;
 
-	for (size_t i = 0; i < transparent_count; i++) {
-	    RenderableWrapper *wrapper     = renderer->transparent_renderables[i];
-        void              *render_data;
-        Renderable        *renderable;
-        
-        if (wrapper->is_entity) {
-            Entity *entity = wrapper->entity;
-            renderable     = Entity_getLODRenderable(entity, wrapper->position, camera_pos);
-            render_data    = entity;
-        }
-        else {
-            renderable  = wrapper->renderable;
-            render_data = renderable->data;
+        RenderableWrapper *wrapper = &renderer->wrapper_pool[item->wrapper];
+        float              dist_sq = Vector3DistanceSqr(wrapper->position, camera_pos);
+        if (dist_sq > max_dist_sq) continue;
+
+        addVisible(view, wrapper, item->wrapper, head, dist_sq);
+    }
+}
+
+
+/*
+	Start head's view of the frame: draw the Scene's occluders for it if it
+	occlusion culls, then cull the shared submissions.
+*/
+static void
+beginView(Renderer *renderer, Head *head, HeadView *view)
+{
+    Scene *scene = Engine_getScene(renderer->engine);
+
+    DynamicArray_clear(view->visible);
+    view->occluded  = 0;
+    view->occluding = false;
+    view->lod_scale = getLODScale(head);
+
+    if (head->settings.occlusion_culling && scene) {
+        if (!view->occlusion)
+            view->occlusion = OcclusionBuffer_new(OCCLUSION_BUFFER_WIDTH, OCCLUSION_BUFFER_HEIGHT);
+
+        if (view->occlusion) {
+            PROFILE_ZONE("Occluders");
+            OcclusionBuffer_begin(view->occlusion, Head_getCamera(head), (float)head->region.width / head->region.height);
+            view->occluding = Scene_drawOccluders(scene, head, view->occlusion);
+            if (view->occluding) OcclusionBuffer_finish(view->occlusion);
         }
-	    if (renderable->Render) {
-            //DrawSphereWires(wrapper->position, 1.0f, 3, 8, YELLOW);
-	        renderable->Render(renderable, render_data, wrapper->position, camera);
-	    }
-	}
+    }
+
+    cullView(renderer, head, view, renderer->shared_pass, 0, renderer->shared_count);
+}
+
+
+/* Gather what every Head might draw, once a frame before any of them render */
+void
+Renderer__submit(Renderer *renderer)
+{
+	PROFILE_ZONE("Renderer__submit");
+	Scene *scene = Engine_getScene(renderer->engine);
+
+	DynamicArray_clear(renderer->wrapper_pool);
+	if (scene) Scene_submit(scene, renderer);
+
+	renderer->shared_count = DynamicArray_length(renderer->wrapper_pool);
+	updateCullItems(renderer, 0, renderer->shared_count, true);
 }
 
+
+typedef struct
+{
+	Renderer  *renderer;
+	Head     **heads;
+}
+CullJob;
+
 static void
-swap_transparent(Renderer *renderer, int i, int j)
+cullHeadRange(void *data, uint start, uint end)
 {
-    float temp_dist = renderer->transparent_distances[i];
-    renderer->transparent_distances[i] = renderer->transparent_distances[j];
-    renderer->transparent_distances[j] = temp_dist;
+	CullJob  *job      = data;
+	Renderer *renderer = job->renderer;
 
-    RenderableWrapper *temp_rend = renderer->transparent_renderables[i];
-    renderer->transparent_renderables[i] = renderer->transparent_renderables[j];
-    renderer->transparent_renderables[j] = temp_rend;
+	for (uint i = start; i < end; i++) {
+		Head     *head = job->heads[i];
+		HeadView *view = &renderer->views[head->index];
 
-    void *temp_data = renderer->transparent_render_data[i];
-    renderer->transparent_render_data[i] = renderer->transparent_render_data[j];
-    renderer->transparent_render_data[j] = temp_data;
+		beginView(renderer, head, view);
+		view->culled = true;
+	}
 }
 
-static int
-partition_transparent(Renderer *renderer, int low, int high)
+/* Cull the shared submissions for each of heads, on the JobSystem if there are several */
+void
+Renderer__cull(Renderer *renderer, Head **heads, uint head_count)
 {
-    float pivot = renderer->transparent_distances[high];
-    int i = low - 1;
+	PROFILE_ZONE("Renderer__cull");
+	CullJob    job  = {renderer, heads};
+	JobSystem *jobs = Engine_getJobSystem(renderer->engine);
 
-    for (int j = low; j < high; j++) {
-        if (renderer->transparent_distances[j] > pivot) {
-            i++;
-            swap_transparent(renderer, i, j);
-        }
+	if (jobs && 1 < head_count) JobSystem_parallelFor(jobs, head_count, 1, cullHeadRange, &job);
+	else cullHeadRange(&job, 0, head_count);
+}
+
+
+/*
+	Most expensive state to change first: the Renderable's material, then
+	its Render callback, standing in for a shader, then its data, standing
+	in for a mesh or texture. The distance fills the low bits, so each
+	state draws front to back, unless the Renderable can draw instanced:
+	then the Renderable itself does, so its users end up side by side.
+*/
+static inline uint64
+makeDrawKey(const Renderable *renderable, float dist_sq, float max_dist_sq)
+{
+    uint64 callback = (uint64)(uintptr_t)renderable->Render * 0x9E3779B97F4A7C15ull;
+    uint64 data     = ((uint64)(uintptr_t)renderable->data >> 3) * 0x9E3779B97F4A7C15ull;
+    uint64 low;
+
+    if (renderable->RenderInstanced) {
+        low = (((uint64)(uintptr_t)renderable >> 3) * 0x9E3779B97F4A7C15ull) >> 48;
+    }
+    else {
+        float depth = (dist_sq < max_dist_sq) ? sqrtf(dist_sq / max_dist_sq) : 1.0f;
+        low = (uint64)(depth * 65535.0f);
     }
 
-    swap_transparent(renderer, ++i, high);
-    return i;
+    return ((uint64)renderable->material << 48)
+        | ((callback >> 56) << 40)
+        | ((data >> 40) << 16)
+        | low;
 }
 
+/* Gather the model matrices of count queued draws of one Renderable, and draw them at once */
 static void
-quicksort_transparent(Renderer *renderer, int low, int high)
+drawInstances(Renderer *renderer, const VisibleItem *visible, const DrawKey *draws, size_t count, Camera3D *camera)
 {
-    if (low < high) {
-        int pi = partition_transparent(renderer, low, high);
-        quicksort_transparent(renderer, low, pi - 1);
-        quicksort_transparent(renderer, pi + 1, high);
+    Renderable *renderable = visible[draws[0].item].selected;
+
+    DynamicArray_clear(renderer->instance_transforms);
+    for (size_t i = 0; i < count; i++) {
+        const RenderableWrapper *wrapper  = &renderer->wrapper_pool[visible[draws[i].item].wrapper];
+        Vector3                  position = wrapper->position;
+        Matrix                   transform = wrapper->is_entity
+            ? Entity_getInstanceTransform(wrapper->entity, position)
+            : MatrixTranslate(position.x, position.y, position.z);
+
+        DynamicArray_add(renderer->instance_transforms, transform);
     }
+
+    renderable->RenderInstanced(renderable, renderer->instance_transforms, count, camera);
 }
 
-static void
-Renderer__sortTransparent(Renderer *renderer)
+/*
+	Sorts non-negative values largest first, e.g. squared distances back to
+	front: their float bits order the same as they do, so inverted bits
+	order the other way.
+*/
+static inline uint64
+makeDescendingKey(float value)
+{
+    uint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    return (uint32)~bits;
+}
+
+/*
+	LSD radix sort on key, a byte a pass, skipping the bytes every key
+	shares. Stable, so equal keys keep their submission order. scratch must
+	hold count keys; returns whichever of the two ends up sorted.
+*/
+static DrawKey *
+radixSortDrawKeys(DrawKey *keys, DrawKey *scratch, size_t count)
+{
+    uint64 differing = 0;
+    for (size_t i = 1; i < count; i++) differing |= keys[i].key ^ keys[0].key;
+
+    for (uint shift = 0; shift < 64; shift += 8) {
+        if (!((differing >> shift) & 0xFF)) continue;
+
+        size_t offsets[256] = {0};
+        for (size_t i = 0; i < count; i++) offsets[(keys[i].key >> shift) & 0xFF]++;
+        for (size_t byte = 0, total = 0; byte < 256; byte++) {
+            size_t bucket = offsets[byte];
+            offsets[byte] = total;
+            total += bucket;
+        }
+        for (size_t i = 0; i < count; i++) scratch[offsets[(keys[i].key >> shift) & 0xFF]++] = keys[i];
+
+        DrawKey *sorted = scratch;
+        scratch = keys;
+        keys    = sorted;
+    }
+
+    return keys;
+}
+
+
+/*
+	Keep at most head's max_entities_per_frame of the Entities in its view,
+	preferring the ones which look biggest: largest for their distance.
+	Other submissions don't count against it. Returns how many were dropped.
+*/
+static uint
+applyEntityBudget(Renderer *renderer, Head *head, HeadView *view)
 {
-    size_t count = DynamicArray_length(renderer->transparent_renderables);
-    if (count <= 1) return;
+    int    budget = head->settings.max_entities_per_frame;
+    size_t count  = DynamicArray_length(view->visible);
+    if (budget <= 0 || count <= (size_t)budget) return 0;
+
+    DynamicArray_clear(renderer->draw_keys);
+    for (size_t i = 0; i < count; i++) {
+        const RenderableWrapper *wrapper = &renderer->wrapper_pool[view->visible[i].wrapper];
+        if (!wrapper->is_entity) continue;
+
+        /* Proportional to the square of its size on screen */
+        float   radius = wrapper->visibility_radius;
+        DrawKey rank   = {
+                .key  = makeDescendingKey(radius * radius / fmaxf(view->visible[i].dist_sq, 1e-6f)),
+                .item = i,
+            };
+        DynamicArray_add(renderer->draw_keys, rank);
+    }
+
+    size_t entity_count = DynamicArray_length(renderer->draw_keys);
+    if (entity_count <= (size_t)budget) return 0;
+
+    DynamicArray_reserve((void**)&renderer->draw_scratch, entity_count);
+    if (DynamicArray_capacity(renderer->draw_scratch) < entity_count) return 0;
+
+    DrawKey *ranked = radixSortDrawKeys(renderer->draw_keys, renderer->draw_scratch, entity_count);
+    for (size_t i = budget; i < entity_count; i++) view->visible[ranked[i].item].selected = NULL;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (view->visible[i].selected) view->visible[kept++] = view->visible[i];
+    }
+    DynamicArray_truncate(view->visible, kept);
 
-    quicksort_transparent(renderer, 0, count - 1);
+    return entity_count - budget;
 }
 
 
+void
+Renderer__render(Renderer *renderer, Head *head)
+{
+	PROFILE_ZONE("Renderer__render");
+	Camera3D    *camera = Head_getCamera(head);
+	Scene       *scene  = Engine_getScene(renderer->engine);
+	EngineStats *stats  = Engine__getStats(renderer->engine);
+	HeadView    *view   = &renderer->views[head->index];
+
+    /* Clear everything but the shared submissions */
+    DynamicArray_truncate(renderer->wrapper_pool, renderer->shared_count);
+    DynamicArray_clear(renderer->transparent_keys);
+
+    /* Not culled by Renderer__cull() this frame */
+    if (!view->culled) beginView(renderer, head, view);
+    view->culled = false;
+
+	/* Step 1: Let scene draw immediate geometry and submit this Head's own */
+    if (scene) {
+        PROFILE_ZONE("Scene_render");
+        Scene_render(scene, head);
+    }
+
+    /* Step 2: Cull those too */
+    size_t wrapper_count = DynamicArray_length(renderer->wrapper_pool);
+    if (renderer->shared_count < wrapper_count) {
+        PROFILE_ZONE("Culling");
+        uint64 pass = head->settings.frustum_culling
+            ? updateCullItems(renderer, renderer->shared_count, wrapper_count, false)
+            : 0;
+        cullView(renderer, head, view, pass, renderer->shared_count, wrapper_count);
+    }
+    stats->renderables_dropped += applyEntityBudget(renderer, head, view);
+
+	VisibleItem *visible       = view->visible;
+	size_t       visible_count = DynamicArray_length(visible);
+    stats->renderables_submitted += wrapper_count;
+    stats->renderables_culled    += wrapper_count - visible_count;
+    stats->renderables_occluded  += view->occluded;
+    
+    /* PASS 1: Queue opaque stuff by render state, collect transparent */
+    {
+        PROFILE_ZONE("Opaque pass");
+        DynamicArray_clear(renderer->draw_keys);
+        float max_dist_sq = head->settings.max_render_distance * head->settings.max_render_distance;
+
+        for (size_t i = 0; i < visible_count; i++) {
+            Renderable *renderable = visible[i].selected;
+
+            if (renderable->transparent) {
+                DrawKey draw = {
+                        .key  = makeDescendingKey(visible[i].dist_sq),
+                        .item = i,
+                    };
+                DynamicArray_add(renderer->transparent_keys, draw);
+            }
+            else if (renderable->Render || renderable->RenderInstanced) {
+                DrawKey draw = {
+                        .key  = makeDrawKey(renderable, visible[i].dist_sq, max_dist_sq),
+                        .item = i,
+                    };
+                DynamicArray_add(renderer->draw_keys, draw);
+            }
+        }
+
+        DrawKey *draws      = renderer->draw_keys;
+        size_t   draw_count = DynamicArray_length(draws);
+
+        DynamicArray_reserve((void**)&renderer->draw_scratch, draw_count);
+        if (head->settings.sort_opaque_entities && draw_count <= DynamicArray_capacity(renderer->draw_scratch))
+            draws = radixSortDrawKeys(draws, renderer->draw_scratch, draw_count);
+
+        for (size_t i = 0, run; i < draw_count; i += run) {
+            VisibleItem       *item        = &visible[draws[i].item];
+            RenderableWrapper *wrapper     = &renderer->wrapper_pool[item->wrapper];
+            Renderable        *renderable  = item->selected;
+            void              *render_data = wrapper->is_entity ? (void*)wrapper->entity : renderable->data;
+
+            /* Anything above the distance bits changing means a state change */
+            if (!i || (draws[i].key ^ draws[i - 1].key) >> 16) stats->render_state_changes++;
+
+            run = 1;
+            if (renderable->RenderInstanced) {
+                while (i + run < draw_count && visible[draws[i + run].item].selected == renderable) run++;
+            }
+
+            if (1 < run || !renderable->Render) {
+                drawInstances(renderer, visible, draws + i, run, camera);
+                stats->instanced_batches++;
+            }
+            else {
+                renderable->Render(renderable, render_data, wrapper->position, camera);
+            }
+            stats->renderables_drawn += run;
+        }
+    }
+
+	/* PASS 2: Sort and render transparent */
+	DrawKey *draws             = renderer->transparent_keys;
+	size_t   transparent_count = DynamicArray_length(draws);
+	if (transparent_count <= 0) return;
+
+    PROFILE_ZONE("Transparent pass");
+    DynamicArray_reserve((void**)&renderer->draw_scratch, transparent_count);
+    if (head->settings.sort_transparent_entities && transparent_count <= DynamicArray_capacity(renderer->draw_scratch)) {
+        draws = radixSortDrawKeys(draws, renderer->draw_scratch, transparent_count);
+        stats->transparent_sorted += transparent_count;
+    }
+
+	for (size_t i = 0; i < transparent_count; i++) {
+	    RenderableWrapper *wrapper     = &renderer->wrapper_pool[visible[draws[i].item].wrapper];
+        Renderable        *renderable  = visible[draws[i].item].selected;
+        void              *render_data = wrapper->is_entity ? (void*)wrapper->entity : renderable->data;
+        
+	    if (renderable->Render) {
+            //DrawSphereWires(wrapper->position, 1.0f, 3, 8, YELLOW);
+	        renderable->Render(renderable, render_data, wrapper->position, camera);
+	        stats->renderables_drawn++;
+	    }
+	}
+}
+
 void 
 Renderer_submitEntity(Renderer *renderer, Entity *entity) {
+    Renderer_submitEntityAt(renderer, entity, Entity_getRenderTransform(entity).translation);
+}
+
+/* Submit an Entity to be drawn somewhere other than where it is, e.g. a wrapped copy */
+void 
+Renderer_submitEntityAt(Renderer *renderer, Entity *entity, Vector3 position) {
+    EntityRenderState state = Entity__getRenderState(entity);
     RenderableWrapper wrapper;
-    wrapper.entity    = entity;
-    wrapper.position  = entity->position;
-    wrapper.bounds    = entity->bounds;
-    wrapper.is_entity = true;
+    wrapper.entity            = entity;
+    wrapper.position          = position;
+    wrapper.bounds            = state.bounds;
+    wrapper.archetype         = state.archetype;
+    wrapper.renderable_offset = state.renderable_offset;
+    wrapper.visibility_radius = state.visibility_radius;
+    wrapper.visible           = state.visible;
+    wrapper.is_entity         = true;
     
     DynamicArray_add(renderer->wrapper_pool, wrapper);
 }
@@ -0,0 +1,206 @@
+#include <string.h>
+
+#include "_replay_.h"
+#include "dynamicarray.h"
+
+
+#define REPLAY_MAGIC   "KRPL"
+#define REPLAY_VERSION 2
+
+
+typedef struct
+ReplayHeader
+{
+	char   magic[4];
+	uint32 version,
+	       seed;
+	int32  tick_rate;
+	double start_time;
+	uint64 input_size,
+	       tick_count;
+}
+ReplayHeader;
+
+
+/******************
+	CONSTRUCTOR
+******************/
+Replay *
+Replay_new(size_t input_size, uint32 seed)
+{
+	if (!input_size) {
+		ERR_OUT("Replay input snapshots need a size.");
+		return NULL;
+	}
+	
+	Replay *replay = malloc(sizeof(Replay));
+	if (!replay) {
+		ERR_OUT("Failed to allocate memory for Replay.");
+		return NULL;
+	}
+	
+	*replay = (Replay){
+			.seed       = seed,
+			.input_size = input_size,
+			.inputs     = DynamicArray_new(input_size, 1024),
+		};
+	if (!replay->inputs) {
+		free(replay);
+		return NULL;
+	}
+	
+	return replay;
+}
+
+Replay *
+Replay_load(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		ERR_OUT("Failed to open Replay file.");
+		return NULL;
+	}
+	
+	ReplayHeader header;
+	if (
+		fread(&header, sizeof(header), 1, file) != 1
+		|| memcmp(header.magic, REPLAY_MAGIC, 4)
+		|| header.version != REPLAY_VERSION
+	) {
+		ERR_OUT("Not a Replay file, or from another version.");
+		fclose(file);
+		return NULL;
+	}
+	
+	Replay *replay = Replay_new(header.input_size, header.seed);
+	if (!replay) {
+		fclose(file);
+		return NULL;
+	}
+	replay->tick_rate  = header.tick_rate;
+	replay->start_time = header.start_time;
+	
+	DynamicArray_reserve((void**)&replay->inputs, header.tick_count + 1);
+	
+	uint8 *input = malloc(header.input_size);
+	for (uint64 i = 0; input && i < header.tick_count; i++) {
+		if (fread(input, header.input_size, 1, file) != 1) {
+			ERR_OUT("Replay file ended early.");
+			break;
+		}
+		DynamicArray_append((void**)&replay->inputs, input, 1);
+	}
+	free(input);
+	fclose(file);
+	
+	return replay;
+}
+
+/*****************
+	DESTRUCTOR
+*****************/
+void
+Replay_free(Replay *self)
+{
+	if (!self) return;
+	
+	DynamicArray_free(self->inputs);
+	free(self);
+}
+
+
+/**********************
+	SETTERS/GETTERS
+**********************/
+uint32
+Replay_getSeed(Replay *self)
+{
+	return self->seed;
+}
+
+/* 0 until recording starts */
+int
+Replay_getTickRate(Replay *self)
+{
+	return self->tick_rate;
+}
+
+double
+Replay_getStartTime(Replay *self)
+{
+	return self->start_time;
+}
+
+size_t
+Replay_getInputSize(Replay *self)
+{
+	return self->input_size;
+}
+
+uint64
+Replay_getTickCount(Replay *self)
+{
+	return DynamicArray_length(self->inputs);
+}
+
+/* NULL past the end of the recording */
+const void *
+Replay_getInput(Replay *self, uint64 tick)
+{
+	if (DynamicArray_length(self->inputs) <= tick) return NULL;
+	
+	return self->inputs + tick * self->input_size;
+}
+
+
+/**************
+	METHODS
+**************/
+bool
+Replay_save(Replay *self, const char *path)
+{
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		ERR_OUT("Failed to open Replay file.");
+		return false;
+	}
+	
+	uint64       tick_count = DynamicArray_length(self->inputs);
+	ReplayHeader header     = {
+			.magic      = REPLAY_MAGIC,
+			.version    = REPLAY_VERSION,
+			.seed       = self->seed,
+			.tick_rate  = self->tick_rate,
+			.start_time = self->start_time,
+			.input_size = self->input_size,
+			.tick_count = tick_count,
+		};
+	
+	bool written = 
+		fwrite(&header, sizeof(header), 1, file) == 1
+		&& (!tick_count || fwrite(self->inputs, self->input_size, tick_count, file) == tick_count);
+	if (!written) {
+		ERR_OUT("Failed to write Replay file.");
+	}
+	
+	return (fclose(file) == 0) && written;
+}
+
+
+/************************
+	PROTECTED METHODS
+************************/
+/* Start a fresh recording at the given tick rate, from start_time */
+void
+Replay__begin(Replay *self, int tick_rate, double start_time)
+{
+	self->tick_rate  = tick_rate;
+	self->start_time = start_time;
+	DynamicArray_clear(self->inputs);
+}
+
+void
+Replay__append(Replay *self, const void *input)
+{
+	DynamicArray_append((void**)&self->inputs, (void*)input, 1);
+}
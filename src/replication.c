@@ -0,0 +1,671 @@
+#include <string.h>
+
+#include "_entity_.h"
+#include "_scene_.h"
+#include "dynamicarray.h"
+#include "engine.h"
+#include "profiler.h"
+#include "replication.h"
+
+
+#define ORIENTATION_MAX   ((1u << REPLICATION_ORIENTATION_BITS) - 1)
+#define ORIENTATION_BITS  (2 + 3 * REPLICATION_ORIENTATION_BITS)
+#define SMALL_DELTA_BITS  10 /* Position deltas sent in this many bits when they fit */
+#define REMOVED_ID        UINT64_MAX
+#define SQRT_2            1.41421356f
+
+#define CHANGED_POSITION    1
+#define CHANGED_ORIENTATION 2
+#define CHANGED_FLAGS       4
+
+
+/* One Entity's state as sent over the wire */
+typedef struct
+EntityState
+{
+	uint64 unique_ID;
+	int32  position[3];  /* In 1/REPLICATION_POSITION_SCALE units */
+	uint32 orientation;  /* Smallest three */
+	uint8  flags;
+}
+EntityState;
+
+typedef struct
+WorldState
+{
+	uint64       tick;
+	EntityState *entities; /* Sorted by unique_ID */
+}
+WorldState;
+
+
+typedef struct
+ReplicaEntity
+{
+	uint64  network_ID;
+	Entity *entity;
+}
+ReplicaEntity;
+
+typedef struct
+Replica
+{
+	Scene               *scene;
+	ReplicaSpawnCallback spawn;
+	ReplicaEntity       *entities; /* Sorted by network_ID */
+	ReplicaEntity       *scratch;  /* Swapped with entities on every apply */
+}
+Replica;
+
+
+typedef struct
+BitWriter
+{
+	uint8  *buffer;
+	size_t  capacity,
+	        size;
+	uint64  scratch;
+	uint    scratch_bits;
+}
+BitWriter;
+
+typedef struct
+BitReader
+{
+	const uint8 *buffer;
+	size_t       size,
+	             position;
+	uint64       scratch;
+	uint         scratch_bits;
+	bool         overflow;
+}
+BitReader;
+
+
+/*****************
+	BIT PACKING
+*****************/
+/* count may be up to 32 */
+static void
+writeBits(BitWriter *writer, uint32 value, uint count)
+{
+	writer->scratch      |= ((uint64)value & ((1ull << count) - 1)) << writer->scratch_bits;
+	writer->scratch_bits += count;
+	
+	while (8 <= writer->scratch_bits) {
+		if (writer->size < writer->capacity) writer->buffer[writer->size] = (uint8)writer->scratch;
+		writer->size++;
+		writer->scratch      >>= 8;
+		writer->scratch_bits  -= 8;
+	}
+}
+
+/* Seven bits at a time, low first, with a continuation bit */
+static void
+writeVarint(BitWriter *writer, uint64 value)
+{
+	do {
+		uint32 group = value & 0x7F;
+		value >>= 7;
+		writeBits(writer, group | (value ? 0x80 : 0), 8);
+	} while (value);
+}
+
+/* Returns the bytes written, or 0 if they didn't fit */
+static size_t
+finishBits(BitWriter *writer)
+{
+	if (writer->scratch_bits) writeBits(writer, 0, 8 - writer->scratch_bits);
+	
+	return (writer->size <= writer->capacity) ? writer->size : 0;
+}
+
+static uint32
+readBits(BitReader *reader, uint count)
+{
+	while (reader->scratch_bits < count) {
+		uint8 byte = 0;
+		if (reader->position < reader->size) byte = reader->buffer[reader->position];
+		else                                 reader->overflow = true;
+		reader->position++;
+		
+		reader->scratch      |= (uint64)byte << reader->scratch_bits;
+		reader->scratch_bits += 8;
+	}
+	
+	uint32 value = reader->scratch & ((1ull << count) - 1);
+	reader->scratch      >>= count;
+	reader->scratch_bits  -= count;
+	return value;
+}
+
+static uint64
+readVarint(BitReader *reader)
+{
+	uint64 value = 0;
+	for (uint shift = 0; shift < 64 && !reader->overflow; shift += 7) {
+		uint32 group = readBits(reader, 8);
+		value |= (uint64)(group & 0x7F) << shift;
+		if (!(group & 0x80)) break;
+	}
+	return value;
+}
+
+static inline uint32
+zigzag(int32 value)
+{
+	return ((uint32)value << 1) ^ (uint32)(value >> 31);
+}
+
+static inline int32
+unzigzag(uint32 value)
+{
+	return (int32)(value >> 1) ^ -(int32)(value & 1);
+}
+
+
+/*******************
+	QUANTISATION
+*******************/
+static int32
+quantisePosition(float value)
+{
+	float scaled = roundf(value * REPLICATION_POSITION_SCALE);
+	return (int32)CLAMP(scaled, -2147483520.0f, 2147483520.0f);
+}
+
+/* Drop the largest component, which the other three and the unit length imply */
+static uint32
+packOrientation(Quaternion orientation)
+{
+	float components[4] = {orientation.x, orientation.y, orientation.z, orientation.w};
+	float length_sq     = 0.0f;
+	for (int i = 0; i < 4; i++) length_sq += components[i] * components[i];
+	
+	/* Entities start with a zeroed orientation, which renders as the identity */
+	if (length_sq < EPSILON) {
+		uint32 zero   = (ORIENTATION_MAX + 1) / 2; /* Nearest to 0 once unpacked */
+		uint32 packed = 3;
+		for (int i = 0; i < 3; i++) packed = (packed << REPLICATION_ORIENTATION_BITS) | zero;
+		return packed;
+	}
+	
+	uint largest = 0;
+	for (uint i = 1; i < 4; i++) {
+		if (fabsf(components[largest]) < fabsf(components[i])) largest = i;
+	}
+	float scale = ((components[largest] < 0.0f) ? -1.0f : 1.0f) / sqrtf(length_sq);
+	
+	uint32 packed = largest;
+	for (uint i = 0; i < 4; i++) {
+		if (i == largest) continue;
+		/* The others lie within +-1/sqrt(2) */
+		float unit = (components[i] * scale * SQRT_2 + 1.0f) * 0.5f;
+		packed = (packed << REPLICATION_ORIENTATION_BITS) 
+			| (uint32)roundf(CLAMP(unit, 0.0f, 1.0f) * ORIENTATION_MAX);
+	}
+	return packed;
+}
+
+static Quaternion
+unpackOrientation(uint32 packed)
+{
+	float components[4];
+	uint  largest   = packed >> (3 * REPLICATION_ORIENTATION_BITS);
+	float length_sq = 0.0f;
+	
+	for (int i = 3; 0 <= i; i--) {
+		if ((uint)i == largest) continue;
+		float unit = (float)(packed & ORIENTATION_MAX) / ORIENTATION_MAX;
+		packed >>= REPLICATION_ORIENTATION_BITS;
+		
+		components[i] = (unit * 2.0f - 1.0f) / SQRT_2;
+		length_sq    += components[i] * components[i];
+	}
+	components[largest] = sqrtf(fmaxf(0.0f, 1.0f - length_sq));
+	
+	return (Quaternion){components[0], components[1], components[2], components[3]};
+}
+
+/* The Entity flags a server decides; the rest are the client's own business */
+static uint8
+replicatedFlags(void)
+{
+	Entity mask = {0};
+	mask.active          = true;
+	mask.visible         = true;
+	mask.solid           = true;
+	mask.collision_shape = 3;
+	return mask.flags;
+}
+
+
+/* For sorting and searching anything starting with a 64-bit ID */
+static int
+compareIDs(const void *a, const void *b)
+{
+	uint64
+		id_a = *(const uint64*)a,
+		id_b = *(const uint64*)b;
+	return (id_a > id_b) - (id_a < id_b);
+}
+
+static EntityState *
+findState(const WorldState *state, size_t count, uint64 unique_ID)
+{
+	if (!count) return NULL;
+	return bsearch(&unique_ID, state->entities, count, sizeof(EntityState), compareIDs);
+}
+
+static uint8
+changeMask(const EntityState *state, const EntityState *base)
+{
+	uint8 mask = 0;
+	if (memcmp(state->position, base->position, sizeof(state->position))) mask |= CHANGED_POSITION;
+	if (state->orientation != base->orientation)                           mask |= CHANGED_ORIENTATION;
+	if (state->flags       != base->flags)                                 mask |= CHANGED_FLAGS;
+	return mask;
+}
+
+
+static void
+writeAxis(BitWriter *writer, int32 value, int32 base)
+{
+	int64 delta = (int64)value - base;
+	
+	if (-(1 << (SMALL_DELTA_BITS - 1)) <= delta && delta < (1 << (SMALL_DELTA_BITS - 1))) {
+		writeBits(writer, 1, 1);
+		writeBits(writer, zigzag((int32)delta), SMALL_DELTA_BITS);
+	}
+	else {
+		writeBits(writer, 0, 1);
+		writeBits(writer, (uint32)value, 32);
+	}
+}
+
+static int32
+readAxis(BitReader *reader, int32 base)
+{
+	if (readBits(reader, 1)) return (int32)((int64)base + unzigzag(readBits(reader, SMALL_DELTA_BITS)));
+	
+	return (int32)readBits(reader, 32);
+}
+
+static void
+writeFields(BitWriter *writer, const EntityState *state, const EntityState *base, uint8 mask)
+{
+	if (mask & CHANGED_POSITION) {
+		for (int i = 0; i < 3; i++) writeAxis(writer, state->position[i], base->position[i]);
+	}
+	if (mask & CHANGED_ORIENTATION) writeBits(writer, state->orientation, ORIENTATION_BITS);
+	if (mask & CHANGED_FLAGS)       writeBits(writer, state->flags,       8);
+}
+
+static void
+readFields(BitReader *reader, EntityState *state, uint8 mask)
+{
+	if (mask & CHANGED_POSITION) {
+		for (int i = 0; i < 3; i++) state->position[i] = readAxis(reader, state->position[i]);
+	}
+	if (mask & CHANGED_ORIENTATION) state->orientation = readBits(reader, ORIENTATION_BITS);
+	if (mask & CHANGED_FLAGS)       state->flags       = readBits(reader, 8);
+}
+
+
+/******************
+	CONSTRUCTOR
+******************/
+WorldState *
+WorldState_new(void)
+{
+	WorldState *state = malloc(sizeof(WorldState));
+	if (!state) {
+		ERR_OUT("Failed to allocate WorldState.");
+		return NULL;
+	}
+	
+	state->tick     = 0;
+	state->entities = DynamicArray(EntityState, 128);
+	return state;
+}
+
+/*****************
+	DESTRUCTOR
+*****************/
+void
+WorldState_free(WorldState *self)
+{
+	if (!self) return;
+	
+	DynamicArray_free(self->entities);
+	free(self);
+}
+
+
+/**********************
+	SETTERS/GETTERS
+**********************/
+uint64
+WorldState_getTick(WorldState *self)
+{
+	return self->tick;
+}
+
+uint
+WorldState_getEntityCount(WorldState *self)
+{
+	return DynamicArray_length(self->entities);
+}
+
+
+/**************
+	METHODS
+**************/
+/* Quantise every Entity in scene as of the current tick */
+void
+WorldState_capture(WorldState *self, Scene *scene)
+{
+	PROFILE_ZONE("WorldState_capture");
+	Entity **entities  = Scene_getEntities(scene);
+	size_t   count     = DynamicArray_length(entities);
+	uint8    flag_mask = replicatedFlags();
+	
+	DynamicArray_clear(self->entities);
+	DynamicArray_reserve((void**)&self->entities, count + 1);
+	self->tick = Engine_getTickNumber(Scene_getEngine(scene));
+	
+	for (size_t i = 0; i < count; i++) {
+		Entity     *entity = entities[i];
+		EntityNode *node   = ENTITY_TO_NODE(entity);
+		if (node->to_delete) continue;
+		
+		EntityState state = {
+				.unique_ID   = node->unique_ID,
+				.position    = {
+					quantisePosition(entity->position.x),
+					quantisePosition(entity->position.y),
+					quantisePosition(entity->position.z)
+				},
+				.orientation = packOrientation(entity->orientation),
+				.flags       = entity->flags & flag_mask,
+			};
+		DynamicArray_add(self->entities, state);
+	}
+	
+	qsort(self->entities, DynamicArray_length(self->entities), sizeof(EntityState), compareIDs);
+}
+
+/* E.g. to keep a history of states for clients to acknowledge */
+void
+WorldState_copy(WorldState *self, const WorldState *source)
+{
+	DynamicArray_clear(self->entities);
+	DynamicArray_concat((void**)&self->entities, source->entities);
+	self->tick = source->tick;
+}
+
+
+/*
+	Write what changed from baseline to state into buffer: the Entities
+	removed, then those added or changed with only the fields that changed.
+	With no baseline every Entity is written in full. Returns the bytes
+	written, or 0 if they didn't fit in capacity.
+*/
+size_t
+WorldState_writeDelta(
+	const WorldState *self, 
+	const WorldState *baseline, 
+	uint8            *buffer, 
+	size_t            capacity
+)
+{
+	PROFILE_ZONE("WorldState_writeDelta");
+	BitWriter writer         = {.buffer = buffer, .capacity = capacity};
+	size_t    count          = DynamicArray_length(self->entities);
+	size_t    baseline_count = baseline ? DynamicArray_length(baseline->entities) : 0;
+	uint64    removed_count  = 0,
+	          changed_count  = 0,
+	          previous_ID    = 0;
+	
+	writeVarint(&writer, self->tick);
+	writeBits(  &writer, baseline != NULL, 1);
+	if (baseline) writeVarint(&writer, baseline->tick);
+	
+	/* Removed */
+	for (size_t i = 0; i < baseline_count; i++) {
+		if (!findState(self, count, baseline->entities[i].unique_ID)) removed_count++;
+	}
+	writeVarint(&writer, removed_count);
+	for (size_t i = 0; i < baseline_count && removed_count; i++) {
+		uint64 unique_ID = baseline->entities[i].unique_ID;
+		if (findState(self, count, unique_ID)) continue;
+		
+		writeVarint(&writer, unique_ID - previous_ID);
+		previous_ID = unique_ID;
+	}
+	
+	/* Added or changed */
+	for (size_t i = 0; i < count; i++) {
+		const EntityState *base = findState(baseline, baseline_count, self->entities[i].unique_ID);
+		if (!base || changeMask(&self->entities[i], base)) changed_count++;
+	}
+	writeVarint(&writer, changed_count);
+	
+	previous_ID = 0;
+	for (size_t i = 0; i < count; i++) {
+		const EntityState *state = &self->entities[i];
+		const EntityState *base  = findState(baseline, baseline_count, state->unique_ID);
+		uint8              mask  = base ? changeMask(state, base) : 0;
+		
+		if (base && !mask) continue;
+		
+		writeVarint(&writer, state->unique_ID - previous_ID);
+		previous_ID = state->unique_ID;
+		
+		writeBits(&writer, base == NULL, 1);
+		if (base) {
+			writeBits(&writer, mask, 3);
+			writeFields(&writer, state, base, mask);
+		}
+		else {
+			writeFields(
+					&writer, 
+					state, 
+					&(EntityState){0}, 
+					CHANGED_POSITION | CHANGED_ORIENTATION | CHANGED_FLAGS
+				);
+		}
+	}
+	
+	return finishBits(&writer);
+}
+
+
+/*
+	Rebuild into state what was written against baseline, which must be the
+	same state the writer used. Returns false if the buffer is malformed or
+	was written against a different baseline.
+*/
+bool
+WorldState_readDelta(
+	WorldState       *self, 
+	const WorldState *baseline, 
+	const uint8      *buffer, 
+	size_t            size
+)
+{
+	PROFILE_ZONE("WorldState_readDelta");
+	BitReader reader = {.buffer = buffer, .size = size};
+	
+	uint64 tick         = readVarint(&reader);
+	bool   has_baseline = readBits(&reader, 1);
+	if (has_baseline && (!baseline || readVarint(&reader) != baseline->tick)) {
+		ERR_OUT("WorldState delta was written against a different baseline.");
+		return false;
+	}
+	
+	DynamicArray_clear(self->entities);
+	if (has_baseline) DynamicArray_concat((void**)&self->entities, baseline->entities);
+	
+	/* Entries past the baseline's aren't sorted until the end */
+	size_t sorted_count  = DynamicArray_length(self->entities);
+	uint64 removed_count = readVarint(&reader),
+	       previous_ID   = 0;
+	
+	/* Marked after the changes, which still need the baseline in ID order */
+	BitReader removals = reader;
+	for (uint64 i = 0; i < removed_count && !reader.overflow; i++) readVarint(&reader);
+	
+	uint64 changed_count = readVarint(&reader);
+	previous_ID = 0;
+	
+	for (uint64 i = 0; i < changed_count && !reader.overflow; i++) {
+		previous_ID += readVarint(&reader);
+		
+		if (readBits(&reader, 1)) {
+			EntityState state = {.unique_ID = previous_ID};
+			readFields(&reader, &state, CHANGED_POSITION | CHANGED_ORIENTATION | CHANGED_FLAGS);
+			DynamicArray_add(self->entities, state);
+			continue;
+		}
+		
+		uint8        mask  = readBits(&reader, 3);
+		EntityState *state = findState(self, sorted_count, previous_ID);
+		EntityState  discard;
+		if (!state) {
+			ERR_OUT("WorldState delta changes an Entity its baseline lacks.");
+			discard = (EntityState){0};
+			state   = &discard;
+		}
+		readFields(&reader, state, mask);
+	}
+	
+	if (reader.overflow) {
+		ERR_OUT("WorldState delta ended early.");
+		return false;
+	}
+	
+	/* Removed IDs ascend, so one walk along the baseline finds them all */
+	size_t cursor = 0;
+	previous_ID   = 0;
+	for (uint64 i = 0; i < removed_count; i++) {
+		previous_ID += readVarint(&removals);
+		
+		while (cursor < sorted_count && self->entities[cursor].unique_ID < previous_ID) cursor++;
+		if (cursor < sorted_count && self->entities[cursor].unique_ID == previous_ID)
+			self->entities[cursor++].unique_ID = REMOVED_ID;
+	}
+	
+	/* Removed entries sort to the end */
+	size_t count = DynamicArray_length(self->entities);
+	qsort(self->entities, count, sizeof(EntityState), compareIDs);
+	while (count && self->entities[count - 1].unique_ID == REMOVED_ID) count--;
+	DynamicArray_truncate(self->entities, count);
+	
+	self->tick = tick;
+	return true;
+}
+
+
+/******************
+	CONSTRUCTOR
+******************/
+/* spawn must create the Entity and add it to scene, or return NULL to skip it */
+Replica *
+Replica_new(Scene *scene, ReplicaSpawnCallback spawn)
+{
+	Replica *replica = malloc(sizeof(Replica));
+	if (!replica) {
+		ERR_OUT("Failed to allocate Replica.");
+		return NULL;
+	}
+	
+	*replica = (Replica){
+			.scene    = scene,
+			.spawn    = spawn,
+			.entities = DynamicArray(ReplicaEntity, 128),
+			.scratch  = DynamicArray(ReplicaEntity, 128),
+		};
+	return replica;
+}
+
+/*****************
+	DESTRUCTOR
+*****************/
+/* The Entities it spawned stay in the Scene */
+void
+Replica_free(Replica *self)
+{
+	if (!self) return;
+	
+	DynamicArray_free(self->entities);
+	DynamicArray_free(self->scratch);
+	free(self);
+}
+
+
+/**********************
+	SETTERS/GETTERS
+**********************/
+/* The local Entity standing in for the server's Entity network_ID */
+Entity *
+Replica_getEntity(Replica *self, uint64 network_ID)
+{
+	ReplicaEntity *found = bsearch(
+			&network_ID, 
+			self->entities, 
+			DynamicArray_length(self->entities), 
+			sizeof(ReplicaEntity), 
+			compareIDs
+		);
+	return found ? found->entity : NULL;
+}
+
+
+/**************
+	METHODS
+**************/
+void
+Replica_apply(Replica *self, const WorldState *state)
+{
+	PROFILE_ZONE("Replica_apply");
+	uint8  flag_mask = replicatedFlags();
+	size_t count     = DynamicArray_length(state->entities),
+	       old_count = DynamicArray_length(self->entities),
+	       j         = 0;
+	
+	DynamicArray_clear(self->scratch);
+	DynamicArray_reserve((void**)&self->scratch, count + 1);
+	
+	/* Both are sorted by ID, so walk them together */
+	for (size_t i = 0; i < count; i++) {
+		const EntityState *entity_state = &state->entities[i];
+		Entity            *entity       = NULL;
+		
+		for (; j < old_count && self->entities[j].network_ID < entity_state->unique_ID; j++)
+			Entity_free(self->entities[j].entity);
+		
+		if (j < old_count && self->entities[j].network_ID == entity_state->unique_ID) 
+			entity = self->entities[j++].entity;
+		else if (self->spawn)
+			entity = self->spawn(self->scene, entity_state->unique_ID);
+		
+		if (!entity) continue;
+		
+		entity->position = (Vector3){
+				entity_state->position[0] / REPLICATION_POSITION_SCALE,
+				entity_state->position[1] / REPLICATION_POSITION_SCALE,
+				entity_state->position[2] / REPLICATION_POSITION_SCALE
+			};
+		entity->orientation = unpackOrientation(entity_state->orientation);
+		entity->flags       = (entity->flags & ~flag_mask) | entity_state->flags;
+		
+		ReplicaEntity replica_entity = {entity_state->unique_ID, entity};
+		DynamicArray_add(self->scratch, replica_entity);
+	}
+	for (; j < old_count; j++) Entity_free(self->entities[j].entity);
+	
+	ReplicaEntity *entities = self->entities;
+	self->entities = self->scratch;
+	self->scratch  = entities;
+}
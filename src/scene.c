@@ -9,6 +9,7 @@
 #include "_renderer_.h"
 #include "common.h"
 #include "dynamicarray.h"
+#include "profiler.h"
 
 
 #define HANDLE_SCENE_CALLBACK(scene, method, ...) do{ \
@@ -21,6 +22,24 @@ void insertScene(Scene *scene, Scene *to);
 void removeScene(Scene *scene);
 
 
+/* Slot for unique_ID in the Entity index; IDs are sequential, so they're scattered first */
+static inline uint32
+hashID(uint64 unique_ID, uint32 mask)
+{
+    return (uint32)((unique_ID * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+/* For sorting and searching anything starting with an Entity address */
+static int
+compareAddresses(const void *a, const void *b)
+{
+    uintptr_t
+        address_a = (uintptr_t)*(const Entity* const*)a,
+        address_b = (uintptr_t)*(const Entity* const*)b;
+    return (address_a > address_b) - (address_a < address_b);
+}
+
+
 /*
     CONSTRUCTOR
 */
@@ -46,6 +65,30 @@ Scene_new(
     scene->info             = info;
     scene->vtable           = map_type;
     scene->entity_list      = DynamicArray(Entity*, 128);
+    scene->update_list      = DynamicArray(Entity*, 128);
+    scene->prev_transforms  = DynamicArray(Transform, 128);
+    scene->commands         = DynamicArray(DeferredCommand, 32);
+    scene->pending_frees    = DynamicArray(EntityNode*, 32);
+    scene->relocations      = DynamicArray(EntityRelocation, 32);
+    scene->id_table         = NULL;
+    scene->id_capacity      = 0;
+    scene->id_count         = 0;
+    scene->flags            = 0;
+    scene->front_view       = 0;
+    scene->view_ready       = false;
+    scene->has_view         = false;
+    
+    for (int i = 0; i < 2; i++) {
+        scene->views[i].entities     = DynamicArray(Entity*, 128);
+        scene->views[i].states       = DynamicArray(EntityRenderState, 128);
+        scene->views[i].tick_elapsed = 0.0f;
+    }
+    
+    JobSystem *jobs = Engine_getJobSystem(engine);
+    scene->command_buffer_count = jobs ? JobSystem_getThreadCount(jobs) : 1;
+    scene->command_buffers      = malloc(sizeof(DeferredCommand*) * scene->command_buffer_count);
+    for (uint i = 0; i < scene->command_buffer_count; i++)
+        scene->command_buffers[i] = DynamicArray(DeferredCommand, 32);
     
     Engine__insertScene(engine, scene);
 
@@ -66,6 +109,21 @@ Scene_free(Scene *scene)
     
 	CollisionScene__free( scene->collision_scene);
 	DynamicArray_free(    scene->entity_list);
+	DynamicArray_free(    scene->update_list);
+	DynamicArray_free(    scene->prev_transforms);
+	DynamicArray_free(    scene->commands);
+	
+	Scene__clearView(scene);
+	DynamicArray_free(scene->pending_frees);
+	DynamicArray_free(scene->relocations);
+	free(scene->id_table);
+	for (int i = 0; i < 2; i++) {
+	    DynamicArray_free(scene->views[i].entities);
+	    DynamicArray_free(scene->views[i].states);
+	}
+	for (uint i = 0; i < scene->command_buffer_count; i++)
+	    DynamicArray_free(scene->command_buffers[i]);
+	free(scene->command_buffers);
     Engine__removeScene(  scene->engine, scene);
     
     free(scene);
@@ -93,6 +151,26 @@ Scene_getEntities(Scene *self)
 	return self->entity_list;
 }
 
+/*
+    The entities to draw. Scene Render callbacks should use this rather than
+    Scene_getEntities(), since in pipelined mode the next tick is changing
+    the live list while they run.
+*/
+Entity **
+Scene_getRenderEntities(Scene *self)
+{
+	/* Pipelined without a view yet, e.g. just switched to: draw nothing rather than race */
+	if (!self->has_view && !Engine_isPipelined(self->engine)) return self->entity_list;
+	
+	return self->views[self->front_view].entities;
+}
+
+uint
+Scene_getRenderEntityCount(Scene *self)
+{
+	return DynamicArray_length(Scene_getRenderEntities(self));
+}
+
 void *
 Scene_getData(Scene *self)
 {
@@ -105,6 +183,17 @@ Scene_getInfo(Scene *self)
     return self->info;
 }
 
+/*
+    Spread the entities' ParallelUpdate callbacks across the Engine's
+    JobSystem. Whether on or off, their deferred commands run in the same
+    order afterwards, so results don't depend on it.
+*/
+void
+Scene_setParallelUpdate(Scene *self, bool parallel)
+{
+    self->parallel_update = parallel;
+}
+
 /*
     PUBLIC METHODS
 */
@@ -119,6 +208,7 @@ Scene_enter(Scene *self)
 void
 Scene_update(Scene *self, float delta)
 {
+    PROFILE_ZONE("Scene_update");
     CollisionScene__update(     self->collision_scene);
     //EntityNode__updateAll(      self->entities, delta);
     Scene__update(self, delta);
@@ -252,6 +342,24 @@ Scene_render(Scene *self, Head *head)
     }
 }
 
+void
+Scene_submit(Scene *self, Renderer *renderer)
+{
+    SceneVTable *vtable = self->vtable;
+    if (vtable && vtable->Submit) vtable->Submit(self, renderer);
+}
+
+/* Returns false if the Scene has no occluders to draw */
+bool
+Scene_drawOccluders(Scene *self, Head *head, OcclusionBuffer *buffer)
+{
+    SceneVTable *vtable = self->vtable;
+    if (!vtable || !vtable->DrawOccluders) return false;
+
+    vtable->DrawOccluders(self, head, buffer);
+    return true;
+}
+
 void
 Scene_exit(Scene *self)
 {
@@ -269,10 +377,117 @@ Scene_queryRegion(Scene *scene, BoundingBox  bbox)
     return result;
 }
 
+Entity *
+Scene_findEntity(Scene *self, uint64 unique_ID)
+{
+    if (!self->id_capacity) return NULL;
+    
+    uint32 mask = self->id_capacity - 1;
+    for (uint32 i = hashID(unique_ID, mask); self->id_table[i]; i = (i + 1) & mask) {
+        if (ENTITY_TO_NODE(self->id_table[i])->unique_ID == unique_ID) return self->id_table[i];
+    }
+    return NULL;
+}
+
+/*
+    What a pointer to an Entity, as it was when the snapshot last restored
+    was taken, should point at now. Pointers to anything else come back as
+    they are. Meant for EntityVTable Restore callbacks.
+*/
+Entity *
+Scene_relocateEntity(Scene *self, const Entity *entity)
+{
+    if (!entity) return NULL;
+    
+    const EntityRelocation *relocation = bsearch(
+            &entity,
+            self->relocations,
+            DynamicArray_length(self->relocations),
+            sizeof(EntityRelocation),
+            compareAddresses
+        );
+    return relocation ? relocation->to : (Entity*)entity;
+}
+
 
 /*
     Private methods
 */
+/*
+    Entity index
+        Linear probing keyed by unique_ID, kept at most half full. Removal
+        shifts the rest of the run back, so there are no tombstones.
+*/
+static void
+insertIntoIndex(Scene *self, Entity *entity)
+{
+    uint32 mask = self->id_capacity - 1;
+    uint32 i    = hashID(ENTITY_TO_NODE(entity)->unique_ID, mask);
+    
+    while (self->id_table[i]) i = (i + 1) & mask;
+    self->id_table[i] = entity;
+    self->id_count++;
+}
+
+static bool
+growIndex(Scene *self, uint32 capacity)
+{
+    Entity **old_table    = self->id_table;
+    uint32   old_capacity = self->id_capacity;
+    
+    Entity **table = calloc(capacity, sizeof(Entity*));
+    if (!table) {
+        ERR_OUT("Failed to grow the Scene's Entity index.");
+        return false;
+    }
+    self->id_table    = table;
+    self->id_capacity = capacity;
+    self->id_count    = 0;
+    
+    for (uint32 i = 0; i < old_capacity; i++) {
+        if (old_table[i]) insertIntoIndex(self, old_table[i]);
+    }
+    free(old_table);
+    
+    return true;
+}
+
+void
+Scene__indexEntity(Scene *self, Entity *entity)
+{
+    if (self->id_capacity < (self->id_count + 1) * 2) {
+        uint32 capacity = self->id_capacity ? self->id_capacity * 2 : 256;
+        if (!growIndex(self, capacity)) return;
+    }
+    insertIntoIndex(self, entity);
+}
+
+void
+Scene__unindexEntity(Scene *self, Entity *entity)
+{
+    if (!self->id_capacity) return;
+    
+    uint32 mask = self->id_capacity - 1;
+    uint32 hole = hashID(ENTITY_TO_NODE(entity)->unique_ID, mask);
+    
+    while (self->id_table[hole] != entity) {
+        if (!self->id_table[hole]) return;
+        hole = (hole + 1) & mask;
+    }
+    self->id_table[hole] = NULL;
+    self->id_count--;
+    
+    /* Pull back whatever can now sit nearer its home slot */
+    for (uint32 i = (hole + 1) & mask; self->id_table[i]; i = (i + 1) & mask) {
+        uint32 home = hashID(ENTITY_TO_NODE(self->id_table[i])->unique_ID, mask);
+        if (((i - home) & mask) < ((i - hole) & mask)) continue;
+        
+        self->id_table[hole] = self->id_table[i];
+        self->id_table[i]    = NULL;
+        hole = i;
+    }
+}
+
 void
 Scene__freeAll(Scene *scene)
 {
@@ -290,6 +505,7 @@ Scene__freeAll(Scene *scene)
 void
 Scene__render(Scene *self, float delta)
 {
+	PROFILE_ZONE("Entity Render callbacks");
 	for (int i = DynamicArray_length(self->entity_list) - 1; 0 <= i; i--) {
 	    Entity       *entity = self->entity_list[i];
 	    
@@ -301,21 +517,549 @@ Scene__render(Scene *self, float delta)
 	}
 }
 
+/* Keep the transforms entities are leaving so they can be interpolated from */
+static void
+snapshotTransforms(Scene *self)
+{
+	DynamicArray_clear(self->prev_transforms);
+	
+	for (size_t i = 0; i < DynamicArray_length(self->entity_list); i++) {
+	    Entity     *entity = self->entity_list[i];
+	    EntityNode *node   = ENTITY_TO_NODE(entity);
+	    
+	    if (!entity->interpolate) {
+	        node->snapshot_index = ENTITY_NO_SNAPSHOT;
+	        continue;
+	    }
+	    node->snapshot_index = DynamicArray_length(self->prev_transforms);
+	    DynamicArray_add(self->prev_transforms, entity->transform);
+	}
+}
+
+static void
+runCommand(Scene *self, DeferredCommand *command)
+{
+	switch (command->type) {
+	case DEFERRED_SPAWN: {
+	    Entity *spawned = Entity_new(
+	            command->template_entity, 
+	            Entity_getEngine(command->issuer), 
+	            command->user_data_size
+	        );
+	    if (!spawned) break;
+	    
+	    spawned->position = command->vector;
+	    if (command->on_spawn) command->on_spawn(command->issuer, spawned);
+	    if (self) Entity_addToScene(spawned, self);
+	    break;
+	}
+	case DEFERRED_FREE:
+	    Entity_free(command->target);
+	    break;
+	case DEFERRED_MOVE:
+	    Entity_move(command->issuer, command->vector);
+	    break;
+	case DEFERRED_MOVE_AND_SLIDE:
+	    Entity_moveAndSlide(command->issuer, command->vector);
+	    break;
+	}
+}
+
+static int
+compareCommands(const void *a, const void *b)
+{
+	const DeferredCommand 
+	    *command_a = a,
+	    *command_b = b;
+	
+	if (command_a->issuer_ID != command_b->issuer_ID)
+	    return (command_a->issuer_ID < command_b->issuer_ID) ? -1 : 1;
+	
+	return (command_a->sequence > command_b->sequence) - (command_a->sequence < command_b->sequence);
+}
+
+/* Run the buffered commands ordered by issuer, whichever thread issued them */
+static void
+flushCommands(Scene *self)
+{
+	DynamicArray_clear(self->commands);
+	
+	for (uint i = 0; i < self->command_buffer_count; i++) {
+	    if (!DynamicArray_length(self->command_buffers[i])) continue;
+	    
+	    DynamicArray_concat((void**)&self->commands, self->command_buffers[i]);
+	    DynamicArray_clear(self->command_buffers[i]);
+	}
+	
+	size_t count = DynamicArray_length(self->commands);
+	if (!count) return;
+	
+	PROFILE_ZONE("Deferred commands");
+	qsort(self->commands, count, sizeof(DeferredCommand), compareCommands);
+	for (size_t i = 0; i < count; i++) runCommand(self, &self->commands[i]);
+}
+
+static void
+parallelUpdateRange(void *data, uint start, uint end)
+{
+	Scene *self = data;
+	
+	for (uint i = start; i < end; i++) {
+	    Entity       *entity = self->update_list[i];
+	    EntityVTable *vtable = entity->vtable;
+	    
+	    if (vtable && vtable->ParallelUpdate)
+	        vtable->ParallelUpdate(entity, ENTITY_TO_NODE(entity)->update_delta);
+	}
+}
+
 void
 Scene__update(Scene *self, float delta)
 {
+	PROFILE_ZONE("Scene__update");
+	uint64 tick_num = Engine_getTickNumber(self->engine);
+	
+	snapshotTransforms(self);
+	DynamicArray_clear(self->update_list);
+	
 	for (int i = DynamicArray_length(self->entity_list) - 1; 0 <= i; i--) {
 	    Entity     *entity = self->entity_list[i];
 	    EntityNode *node   = ENTITY_TO_NODE(entity);
 
 	    if (node->to_delete) {
 	        DynamicArray_delete(self->entity_list, i, 1);
-	        EntityNode__free(node);
+	        Scene__unindexEntity(self, entity);
+	        /* The frame being drawn may still be reading it */
+	        if (Engine_isPipelined(self->engine)) DynamicArray_add(self->pending_frees, node);
+	        else                                  EntityNode__free(node);
 	        continue;
 	    }
         if (!entity->active) continue;
         
+        node->update_delta += delta;
+        if (entity->update_lod) {
+            /* Stagger by ID so a bucket's entities don't all land on the same tick */
+            uint64 period = 1 << Engine__getUpdateBucket(self->engine, entity->position);
+            if ((tick_num + node->unique_ID) & (period - 1)) continue;
+        }
+        
+        DynamicArray_add(self->update_list, entity);
+	}
+	
+	/* Parallel phase: entities only touch themselves, the rest is deferred */
+	uint       count = DynamicArray_length(self->update_list);
+	JobSystem *jobs  = Engine_getJobSystem(self->engine);
+	
+	ENGINE_STAT_ADD(self->engine, entities_updated, count);
+	
+	{
+	    PROFILE_ZONE("Entity ParallelUpdate");
+	    self->deferring = true;
+	    if (self->parallel_update && jobs) {
+	        JobSystem_parallelFor(jobs, count, SCENE_UPDATE_BATCH_SIZE, parallelUpdateRange, self);
+	    }
+	    else {
+	        parallelUpdateRange(self, 0, count);
+	    }
+	    self->deferring = false;
+	}
+	
+	flushCommands(self);
+	
+	/* Serial phase */
+	PROFILE_ZONE("Entity Update");
+	for (uint i = 0; i < count; i++) {
+	    Entity     *entity = self->update_list[i];
+	    EntityNode *node   = ENTITY_TO_NODE(entity);
+	    
+	    if (node->to_delete || node->scene != self) continue;
+	    
+	    float update_delta = node->update_delta;
+	    node->update_delta = 0.0f;
+	    
 	    EntityVTable *vtable = entity->vtable;
-	    if (vtable && vtable->Update) vtable->Update(entity, delta);
+	    if (vtable && vtable->Update) vtable->Update(entity, update_delta);
+	}
+}
+
+/*
+    Pipelined rendering
+        The simulation publishes the entities as they stand after its ticks
+        to the back view, and the main thread swaps it to the front between
+        frames, when neither is running.
+*/
+void
+Scene__publishView(Scene *self, float tick_elapsed)
+{
+	uint8      back = self->front_view ^ 1;
+	SceneView *view = &self->views[back];
+	size_t     count = DynamicArray_length(self->entity_list);
+	
+	DynamicArray_clear(view->entities);
+	DynamicArray_clear(view->states);
+	DynamicArray_reserve((void**)&view->entities, count);
+	DynamicArray_reserve((void**)&view->states,   count);
+	
+	for (size_t i = 0; i < count; i++) {
+	    Entity            *entity = self->entity_list[i];
+	    EntityNode        *node   = ENTITY_TO_NODE(entity);
+	    EntityRenderState  state  = {
+	            .prev_transform    = entity->transform,
+	            .transform         = entity->transform,
+	            .archetype         = entity->archetype,
+	            .bounds            = entity->bounds,
+	            .renderable_offset = entity->renderable_offset,
+	            .visibility_radius = entity->visibility_radius,
+	            .current_anim      = entity->current_anim,
+	            .anim_frame        = entity->anim_frame,
+	            .visible           = entity->visible,
+	            .interpolate       = entity->interpolate
+	        };
+	    
+	    if (node->snapshot_index < DynamicArray_length(self->prev_transforms))
+	        state.prev_transform = self->prev_transforms[node->snapshot_index];
+	    
+	    node->view_index[back] = i;
+	    DynamicArray_add(view->entities, entity);
+	    DynamicArray_add(view->states,   state);
+	}
+	view->tick_elapsed = tick_elapsed;
+	self->view_ready   = true;
+}
+
+void
+Scene__swapView(Scene *self)
+{
+	if (self->view_ready) {
+	    self->front_view ^= 1;
+	    self->view_ready  = false;
+	    self->has_view    = true;
+	}
+	
+	/* Nothing in the new front view can point at these anymore */
+	for (size_t i = 0; i < DynamicArray_length(self->pending_frees); i++)
+	    EntityNode__free(self->pending_frees[i]);
+	DynamicArray_clear(self->pending_frees);
+}
+
+/* Back to rendering the live entities, e.g. on leaving pipelined mode */
+void
+Scene__clearView(Scene *self)
+{
+	self->view_ready = false;
+	Scene__swapView(self);
+	self->has_view   = false;
+	
+	/* Their entities may be freed before the views are next published */
+	for (int i = 0; i < 2; i++) {
+	    DynamicArray_clear(self->views[i].entities);
+	    DynamicArray_clear(self->views[i].states);
+	}
+}
+
+/* Buffer a command if in the parallel phase, otherwise just run it */
+void
+Scene__defer(Scene *self, DeferredCommand *command)
+{
+	if (!self || !self->deferring) {
+	    runCommand(self, command);
+	    return;
 	}
+	
+	uint thread = JobSystem_getThreadIndex(Engine_getJobSystem(self->engine));
+	if (self->command_buffer_count <= thread) thread = 0;
+	
+	DeferredCommand **buffer = &self->command_buffers[thread];
+	command->sequence = DynamicArray_length(*buffer);
+	DynamicArray_append((void**)buffer, command, 1);
+}
+
+
+/*
+    Snapshots
+        Every Entity's node, user data included, copied back to back into one
+        buffer. Restoring writes them back over the Entities that still
+        exist, so pointers to those stay valid; Entities freed since come
+        back at new addresses, so each Entity's Restore callback gets to
+        pass the Entity pointers it holds through Scene_relocateEntity().
+        Other pointers, user_data included, are copied as they are.
+*/
+#define SNAPSHOT_UNCHANGED SIZE_MAX
+
+/* Precedes the Entity and its user data in a snapshot's data */
+typedef struct
+SnapshotRecord
+{
+    uint64 unique_ID;
+    size_t size;          /* Of the EntityNode, user data included */
+    double creation_time;
+    float  update_delta;
+    int8   current_lod[MAX_NUM_HEADS];
+    uint8  flags;
+}
+SnapshotRecord;
+
+typedef struct
+LiveEntity
+{
+    uint64  unique_ID;
+    Entity *entity;    /* NULL once claimed by a record */
+}
+LiveEntity;
+
+/* For sorting and searching anything starting with a unique_ID */
+static int
+compareIDs(const void *a, const void *b)
+{
+    uint64
+        id_a = *(const uint64*)a,
+        id_b = *(const uint64*)b;
+    return (id_a > id_b) - (id_a < id_b);
+}
+
+/* An Entity's record in a full snapshot, NULL if it isn't there */
+static const uint8 *
+findBaseRecord(const SceneSnapshot *base, uint64 unique_ID)
+{
+    const SnapshotEntry *entry = bsearch(
+            &unique_ID,
+            base->sorted,
+            DynamicArray_length(base->sorted),
+            sizeof(SnapshotEntry),
+            compareIDs
+        );
+    return entry ? base->data + entry->offset : NULL;
+}
+
+/* An entry's record, from a delta's base if unchanged */
+static const uint8 *
+findRecord(const SceneSnapshot *snapshot, const SnapshotEntry *entry)
+{
+    if (entry->offset != SNAPSHOT_UNCHANGED) return snapshot->data + entry->offset;
+    if (!snapshot->base) return NULL;
+    
+    return findBaseRecord(snapshot->base, entry->unique_ID);
+}
+
+
+SceneSnapshot *
+SceneSnapshot_new(void)
+{
+    SceneSnapshot *snapshot = malloc(sizeof(SceneSnapshot));
+    if (!snapshot) {
+        ERR_OUT("Failed to allocate SceneSnapshot.");
+        return NULL;
+    }
+    
+    *snapshot = (SceneSnapshot){
+            .base    = NULL,
+            .entries = DynamicArray(SnapshotEntry, 128),
+            .sorted  = DynamicArray(SnapshotEntry, 128),
+            .data    = DynamicArray(uint8, 4096),
+        };
+    return snapshot;
+}
+
+void
+SceneSnapshot_free(SceneSnapshot *snapshot)
+{
+    if (!snapshot) return;
+    
+    DynamicArray_free(snapshot->entries);
+    DynamicArray_free(snapshot->sorted);
+    DynamicArray_free(snapshot->data);
+    free(snapshot);
+}
+
+/* Bytes of entity records held, not counting those left in a delta's base */
+size_t
+SceneSnapshot_getSize(SceneSnapshot *snapshot)
+{
+    return DynamicArray_length(snapshot->data);
+}
+
+
+/*
+    Capture the Scene into snapshot, reusing its memory. With a base, only
+    the Entities which changed since it are stored, and the delta can only
+    be restored while base is unchanged. base must be a full snapshot.
+*/
+void
+Scene_snapshot(Scene *self, SceneSnapshot *snapshot, const SceneSnapshot *base)
+{
+    PROFILE_ZONE("Scene_snapshot");
+    size_t count = DynamicArray_length(self->entity_list);
+    
+    if (base && base->base) {
+        ERR_OUT("Snapshot deltas need a full base; taking a full snapshot.");
+        base = NULL;
+    }
+    
+    DynamicArray_clear(snapshot->entries);
+    DynamicArray_clear(snapshot->sorted);
+    DynamicArray_clear(snapshot->data);
+    DynamicArray_reserve((void**)&snapshot->entries, count + 1);
+    DynamicArray_reserve((void**)&snapshot->sorted,  count + 1);
+    
+    snapshot->base    = base;
+    snapshot->next_ID = Entity__getNextID();
+    
+    for (size_t i = 0; i < count; i++) {
+        Entity     *entity = self->entity_list[i];
+        EntityNode *node   = ENTITY_TO_NODE(entity);
+        
+        if (node->to_delete) continue;
+        
+        /* Zeroed first so padding compares equal against the base */
+        SnapshotRecord record;
+        memset(&record, 0, sizeof(record));
+        record.unique_ID     = node->unique_ID;
+        record.size          = node->size;
+        record.creation_time = node->creation_time;
+        record.update_delta  = node->update_delta;
+        record.flags         = node->flags;
+        memcpy(record.current_lod, node->current_lod, sizeof(record.current_lod));
+        
+        size_t        body_size = node->size - offsetof(EntityNode, base);
+        SnapshotEntry entry     = {
+                .unique_ID = node->unique_ID,
+                .offset    = DynamicArray_length(snapshot->data),
+                .address   = entity
+            };
+        
+        if (base) {
+            const uint8 *base_record = findBaseRecord(base, node->unique_ID);
+            if (
+                base_record
+                && !memcmp(base_record, &record, sizeof(record))
+                && !memcmp(base_record + sizeof(record), entity, body_size)
+            ) entry.offset = SNAPSHOT_UNCHANGED;
+        }
+        
+        if (entry.offset != SNAPSHOT_UNCHANGED) {
+            DynamicArray_append((void**)&snapshot->data, &record, sizeof(record));
+            DynamicArray_append((void**)&snapshot->data, entity,  body_size);
+        }
+        DynamicArray_add(snapshot->entries, entry);
+    }
+    
+    DynamicArray_concat((void**)&snapshot->sorted, snapshot->entries);
+    qsort(
+            snapshot->sorted,
+            DynamicArray_length(snapshot->sorted),
+            sizeof(SnapshotEntry),
+            compareIDs
+        );
+}
+
+
+/*
+    Put every Entity back as it was in snapshot: Entities created since are
+    freed and ones freed since are recreated, without calling any of their
+    callbacks but Free and, once all are back, Restore. The collision
+    structures and the Entity index are rebuilt in one pass. Call between
+    ticks.
+*/
+void
+Scene_restore(Scene *self, const SceneSnapshot *snapshot)
+{
+    PROFILE_ZONE("Scene_restore");
+    
+    size_t      live_count = DynamicArray_length(self->entity_list);
+    size_t      count      = DynamicArray_length(snapshot->entries);
+    LiveEntity *live       = malloc(sizeof(LiveEntity) * (live_count + 1));
+    Entity    **restored   = DynamicArray(Entity*, count + 1);
+    if (!live || !restored) {
+        ERR_OUT("Failed to allocate memory to restore SceneSnapshot.");
+        free(live);
+        if (restored) DynamicArray_free(restored);
+        return;
+    }
+    
+    /* Live Entities by ID, each claimed by at most one record */
+    for (size_t i = 0; i < live_count; i++) {
+        Entity *entity = self->entity_list[i];
+        live[i] = (LiveEntity){ENTITY_TO_NODE(entity)->unique_ID, entity};
+    }
+    qsort(live, live_count, sizeof(LiveEntity), compareIDs);
+    DynamicArray_clear(self->relocations);
+    
+    for (size_t i = 0; i < count; i++) {
+        const uint8 *data = findRecord(snapshot, &snapshot->entries[i]);
+        if (!data) continue;
+        
+        SnapshotRecord record;
+        memcpy(&record, data, sizeof(record));
+        
+        LiveEntity *match = bsearch(&record.unique_ID, live, live_count, sizeof(LiveEntity), compareIDs);
+        EntityNode *node  = NULL;
+        
+        if (match && match->entity && ENTITY_TO_NODE(match->entity)->size == record.size) {
+            node          = ENTITY_TO_NODE(match->entity);
+            match->entity = NULL;
+        }
+        else {
+            node = malloc(record.size);
+            if (!node) {
+                ERR_OUT("Failed to allocate memory for restored EntityNode.");
+                continue;
+            }
+            ENGINE_STAT_ADD(self->engine, allocations, 1);
+            
+            node->next          = node;
+            node->prev          = node;
+            node->engine        = self->engine;
+            node->batch         = NULL;
+            node->size          = record.size;
+            node->view_index[0] = ENTITY_NO_SNAPSHOT;
+            node->view_index[1] = ENTITY_NO_SNAPSHOT;
+        }
+        
+        memcpy(&node->base, data + sizeof(record), record.size - offsetof(EntityNode, base));
+        node->unique_ID      = record.unique_ID;
+        node->creation_time  = record.creation_time;
+        node->update_delta   = record.update_delta;
+        node->flags          = record.flags;
+        node->scene          = self;
+        node->snapshot_index = ENTITY_NO_SNAPSHOT;
+        memcpy(node->current_lod, record.current_lod, sizeof(node->current_lod));
+        
+        Entity          *entity     = NODE_TO_ENTITY(node);
+        EntityRelocation relocation = {snapshot->entries[i].address, entity};
+        DynamicArray_add(restored,          entity);
+        DynamicArray_add(self->relocations, relocation);
+    }
+    qsort(
+            self->relocations,
+            DynamicArray_length(self->relocations),
+            sizeof(EntityRelocation),
+            compareAddresses
+        );
+    
+    /* Whatever wasn't claimed didn't exist yet */
+    for (size_t i = 0; i < live_count; i++) {
+        if (!live[i].entity) continue;
+        
+        EntityNode *node = ENTITY_TO_NODE(live[i].entity);
+        node->scene = NULL;
+        if (Engine_isPipelined(self->engine)) DynamicArray_add(self->pending_frees, node);
+        else                                  EntityNode__free(node);
+    }
+    free(live);
+    
+    DynamicArray_free(self->entity_list);
+    self->entity_list = restored;
+    DynamicArray_clear(self->prev_transforms);
+    Entity__setNextID(snapshot->next_ID);
+    
+    if (self->id_capacity) memset(self->id_table, 0, self->id_capacity * sizeof(Entity*));
+    self->id_count = 0;
+    for (size_t i = 0; i < DynamicArray_length(restored); i++) Scene__indexEntity(self, restored[i]);
+    
+    CollisionScene__update(self->collision_scene);
+    
+    for (size_t i = 0; i < DynamicArray_length(restored); i++) {
+        EntityVTable *vtable = restored[i]->vtable;
+        if (vtable && vtable->Restore) vtable->Restore(restored[i]);
+    }
 }
@@ -109,7 +109,11 @@ SpatialHash_new(void)
         return NULL;
     }
 
-    memset(hash->cells, 0, sizeof(hash->cells));
+    memset(hash->cells,         0, sizeof(hash->cells));
+    memset(hash->chain_lengths, 0, sizeof(hash->chain_lengths));
+    hash->entry_count = 0;
+    hash->used_cells  = 0;
+    hash->max_chain   = 0;
 
     hash->entry_pool = malloc(sizeof(SpatialEntry) * ENTRY_POOL_SIZE);
     hash->pool_size  = ENTRY_POOL_SIZE;
@@ -146,8 +150,12 @@ SpatialHash_clear(SpatialHash *hash)
             freeEntry(hash, entry);
             entry = next;
         }
-        hash->cells[i] = NULL;
+        hash->cells[i]         = NULL;
+        hash->chain_lengths[i] = 0;
     }
+    hash->entry_count = 0;
+    hash->used_cells  = 0;
+    hash->max_chain   = 0;
 }
 
 /* Insert entity */
@@ -184,6 +192,11 @@ SpatialHash_insert(SpatialHash *hash, void *data, Vector3 center, Vector3 bounds
                 entry->position       = center;
                 entry->bbox           = bbox;
                 hash->cells[hash_key] = entry;
+                
+                uint length = ++hash->chain_lengths[hash_key];
+                hash->entry_count++;
+                if (length == 1)              hash->used_cells++;
+                if (hash->max_chain < length) hash->max_chain = length;
             }
         }
     }
@@ -233,3 +246,18 @@ SpatialHash_queryRegion(
 
     return query_results;
 }
+
+
+/* Counted as entries go in, so cheap enough to read every tick */
+void
+SpatialHash_getChainStats(
+    SpatialHash *hash, 
+    uint        *entry_count, 
+    uint        *used_cells, 
+    uint        *max_chain
+)
+{
+    *entry_count = hash->entry_count;
+    *used_cells  = hash->used_cells;
+    *max_chain   = hash->max_chain;
+}